@@ -22,6 +22,12 @@
 #include <bitcoin/server/server_node.hpp>
 #include <bitcoin/server/settings.hpp>
 #include <bitcoin/server/version.hpp>
+#include <bitcoin/server/caches/balance_cache.hpp>
+#include <bitcoin/server/caches/filter_cache.hpp>
+#include <bitcoin/server/caches/header_cache.hpp>
+#include <bitcoin/server/caches/history_cache.hpp>
+#include <bitcoin/server/caches/merkle_cache.hpp>
+#include <bitcoin/server/caches/reorg_journal.hpp>
 #include <bitcoin/server/interface/blockchain.hpp>
 #include <bitcoin/server/interface/server.hpp>
 #include <bitcoin/server/interface/subscribe.hpp>
@@ -34,10 +40,18 @@
 #include <bitcoin/server/services/heartbeat_service.hpp>
 #include <bitcoin/server/services/query_service.hpp>
 #include <bitcoin/server/services/transaction_service.hpp>
+#include <bitcoin/server/utility/compressor.hpp>
+#include <bitcoin/server/utility/filter_matcher.hpp>
+#include <bitcoin/server/utility/history_encoder.hpp>
+#include <bitcoin/server/utility/key_journal.hpp>
+#include <bitcoin/server/utility/payment_key.hpp>
+#include <bitcoin/server/utility/submission_queue.hpp>
+#include <bitcoin/server/utility/transaction_batch.hpp>
 #include <bitcoin/server/web/block_socket.hpp>
 #include <bitcoin/server/web/default_page_data.hpp>
 #include <bitcoin/server/web/heartbeat_socket.hpp>
 #include <bitcoin/server/web/query_socket.hpp>
+#include <bitcoin/server/web/session_socket.hpp>
 #include <bitcoin/server/web/transaction_socket.hpp>
 #include <bitcoin/server/workers/authenticator.hpp>
 #include <bitcoin/server/workers/notification_worker.hpp>
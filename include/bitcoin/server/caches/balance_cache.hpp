@@ -0,0 +1,179 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_CACHES_BALANCE_CACHE_HPP
+#define LIBBITCOIN_SERVER_CACHES_BALANCE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <bitcoin/blockchain.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/utility/key_journal.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// Aggregates of recently queried payment keys, populated from their history
+// upon first query and then maintained from block reorganizations (with a
+// journal for rollback) and from transaction pool announcements. Keys are
+// evicted in order of population once the limit is reached. Spends are
+// valued from the unspent outputs of cached keys, which are retained with
+// them, so the previous outputs of announced transactions are not required.
+// The keys of a pool transaction that conflicts with a confirmed spend or
+// that remains in the pool for several blocks are evicted (the pool does not
+// announce the removal of transactions).
+class BCS_API balance_cache
+{
+public:
+    /// Heights are max_uint32 for a key without confirmed transactions.
+    /// The status is the xor of the digests of distinct history entries.
+    struct balance
+    {
+        uint64_t confirmed;
+        int64_t unconfirmed;
+        uint32_t transactions;
+        uint32_t first_height;
+        uint32_t last_height;
+        system::hash_digest status;
+    };
+
+    /// The unconfirmed value change of a key by a pool transaction, with the
+    /// checksums of the points of the key that it spends.
+    struct pool_delta
+    {
+        int64_t value;
+        std::vector<uint64_t> spends;
+    };
+
+    /// The unconfirmed value changes of a key by pool transaction hash.
+    typedef std::unordered_map<system::hash_digest, pool_delta> pool_deltas;
+
+    /// The values of the unspent outputs of a key by point checksum.
+    typedef std::unordered_map<uint64_t, uint64_t> point_values;
+
+    /// Compute the balance of a key from its history, with its pool deltas
+    /// and its outputs without a confirmed spend.
+    static balance compute(const system::chain::payment_record::list& payments,
+        pool_deltas& pool, point_values& unspent);
+
+    /// Add or remove a (tx hash, height) history entry from the status.
+    /// The height of an unconfirmed entry is max_uint32.
+    static void toggle(system::hash_digest& status,
+        const system::hash_digest& tx_hash, size_t height);
+
+    /// Construct an empty cache of up to limit keys (zero disables).
+    balance_cache(size_t limit);
+
+    /// Set the confirmed top from the store.
+    bool initialize(const bc::blockchain::fast_chain& chain);
+
+    /// Changes with each block reorganization and pool transaction.
+    size_t sequence() const;
+
+    /// The cached balance of the key, false if not cached.
+    bool get(balance& out, const system::hash_digest& key) const;
+
+    /// Cache the balance computed from a history read at the sequence, false
+    /// if not cached (a block or a pool transaction of the key has since been
+    /// announced).
+    bool put(const system::hash_digest& key, const balance& value,
+        const pool_deltas& pool, const point_values& unspent,
+        size_t sequence);
+
+    /// Roll back to the fork point and apply the incoming blocks.
+    void reorganize(size_t fork_height,
+        const system::block_const_ptr_list& incoming);
+
+    /// Apply an unconfirmed transaction.
+    void notify(const system::chain::transaction& tx);
+
+private:
+    // The height is the top at which the balance was populated.
+    struct cached
+    {
+        balance value;
+        size_t height;
+        std::vector<uint64_t> points;
+    };
+
+    struct owned_output
+    {
+        system::hash_digest key;
+        uint64_t value;
+    };
+
+    typedef std::unordered_map<system::hash_digest, cached> cache_map;
+    typedef std::unordered_map<system::hash_digest, balance> balance_map;
+    typedef std::unordered_map<system::hash_digest, int64_t> key_deltas;
+    typedef std::unordered_map<uint64_t, owned_output> output_map;
+
+    // The block count is that at which the transaction was announced.
+    struct pooled
+    {
+        key_deltas deltas;
+        std::vector<uint64_t> spends;
+        size_t blocks;
+    };
+
+    typedef std::unordered_map<system::hash_digest, pooled> pool_map;
+
+    struct journal_entry
+    {
+        size_t height;
+        balance_map previous;
+        pool_map confirmed;
+        output_map spent;
+    };
+
+    key_deltas to_deltas(const system::chain::transaction& tx) const;
+    void add_outputs(const system::chain::transaction& tx,
+        const system::hash_digest& hash);
+    void apply(size_t height, const system::chain::block& block,
+        std::unordered_set<uint64_t>& spent);
+    void expire(const std::unordered_set<uint64_t>& spent);
+    bool rollback(size_t fork_height);
+    void remove(const system::hash_digest& key);
+    void evict();
+    void clear();
+
+    const size_t limit_;
+
+    // These are protected by mutex.
+    size_t top_;
+    size_t sequence_;
+    size_t reorganized_;
+    size_t blocks_;
+    cache_map balances_;
+    output_map outputs_;
+    std::deque<system::hash_digest> order_;
+    std::deque<journal_entry> journal_;
+    pool_map pool_;
+    key_journal announced_;
+    mutable system::shared_mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_CACHES_FILTER_CACHE_HPP
+#define LIBBITCOIN_SERVER_CACHES_FILTER_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// The serialized basic compact filters and filter headers of the most recent
+// confirmed blocks. Each reorganization advances the generation of the
+// window, so that filters loaded for a superseded chain are not accepted.
+class BCS_API filter_cache
+{
+public:
+    /// The filter type of the cached filters (basic).
+    static const uint8_t filter_type;
+
+    /// Construct an empty cache of up to limit filters (0 disables).
+    filter_cache(size_t limit);
+
+    /// Drop filters above the fork point and position the window to end at
+    /// the top. Sets start to the first height to be loaded and returns the
+    /// new generation of the window.
+    size_t reorganize(size_t& start, size_t fork_height, size_t top_height);
+
+    /// Append the filter and its header at the next height of the window,
+    /// false if the generation is superseded or the height is not next.
+    bool push(size_t generation, size_t height,
+        const system::hash_digest& header,
+        const system::compact_filter& filter);
+
+    /// Append [header:32][filter] for each height from start through the
+    /// stop block, up to maximum, and set count to the number appended.
+    /// Returns false if the range is not cached.
+    bool get(system::data_chunk& out, size_t& count, size_t start,
+        const system::hash_digest& stop_hash, size_t maximum) const;
+
+    /// The block hash and encoded filter at the height, false if not cached.
+    bool get_filter(system::hash_digest& block_hash, system::data_chunk& out,
+        size_t height) const;
+
+    /// The number of cached filters.
+    size_t size() const;
+
+private:
+    struct entry
+    {
+        system::hash_digest block_hash;
+        system::hash_digest header;
+        system::data_chunk filter;
+    };
+
+    typedef std::unordered_map<system::hash_digest, size_t> height_map;
+
+    // This is thread safe.
+    const size_t limit_;
+
+    // These are protected by mutex.
+    size_t generation_;
+    size_t first_;
+    std::deque<entry> window_;
+    height_map heights_;
+    mutable system::shared_mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
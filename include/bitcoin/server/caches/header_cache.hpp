@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_CACHES_HEADER_CACHE_HPP
+#define LIBBITCOIN_SERVER_CACHES_HEADER_CACHE_HPP
+
+#include <cstddef>
+#include <unordered_map>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// The confirmed header chain as a contiguous array of serialized headers
+// indexed by height, with a hash to height index. This is loaded from the
+// store in height order after startup and is maintained from block
+// reorganizations, including those that arrive while loading.
+class BCS_API header_cache
+{
+public:
+    static const size_t header_size;
+
+    /// Construct an empty cache.
+    header_cache();
+
+    /// Append a header read from the store at the height.
+    /// Returns false if the height is not the cached top + 1 or if the header
+    /// does not link to the cached top (superseded by a reorganization).
+    bool push(size_t height, const system::chain::header& header);
+
+    /// Remove the cached top header if it is at the height, so that a load
+    /// that does not link to it resumes below it. Returns false if not top.
+    bool pop(size_t height);
+
+    /// Pop to the fork point and push the incoming headers.
+    /// Returns false if the fork point is above the cached top.
+    bool reorganize(size_t fork_height,
+        const system::block_const_ptr_list& incoming);
+
+    /// The number of cached headers (top height + 1).
+    size_t size() const;
+
+    /// Append the serialized header at the height, false if not cached.
+    bool get_header(system::data_chunk& out, size_t height) const;
+
+    /// Append up to count consecutive serialized headers from start height,
+    /// returns the number appended.
+    size_t get_headers(system::data_chunk& out, size_t start,
+        size_t count) const;
+
+    /// The height of the header by hash, false if not cached.
+    bool get_height(size_t& out, const system::hash_digest& hash) const;
+
+private:
+    typedef std::unordered_map<system::hash_digest, size_t> height_map;
+
+    void append(const system::chain::header& header);
+    void pop_above(size_t height);
+
+    // These are protected by mutex.
+    system::data_chunk headers_;
+    height_map heights_;
+    mutable system::shared_mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
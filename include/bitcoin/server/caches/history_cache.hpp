@@ -0,0 +1,151 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_CACHES_HISTORY_CACHE_HPP
+#define LIBBITCOIN_SERVER_CACHES_HISTORY_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/utility/key_journal.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// The full histories of frequently queried payment keys, within a memory
+// budget. Admission is frequency based (TinyLFU): a key is admitted only if
+// it is estimated to be more frequently queried than the entries it would
+// evict, with estimates from an aging count-min sketch of all queries.
+// Queries share the lock, so the sketch is atomic and recency is approximated
+// by a referenced bit, applied when victims are selected (second chance).
+// Cached histories are appended from block and pool announcements. Spends
+// are attributed by the outputs of cached keys, indexed by point, so the
+// previous outputs of announced transactions are not required (a cached
+// history is complete, so it holds every output that a spend of its key may
+// reference). A key with confirmed records above a reorganization's fork
+// point is evicted, as is a key with an unconfirmed record that conflicts
+// with a confirmed spend or that has remained unconfirmed for several blocks
+// (the pool does not announce the removal of transactions).
+class BCS_API history_cache
+{
+public:
+    /// Construct an empty cache of up to budget bytes (zero disables).
+    history_cache(size_t budget);
+
+    /// The number of queries served from the cache.
+    size_t hits() const;
+
+    /// The number of queries not served from the cache.
+    size_t misses() const;
+
+    /// The number of keys admitted to the cache.
+    size_t admissions() const;
+
+    /// The number of keys refused admission to the cache.
+    size_t rejections() const;
+
+    /// Changes with each block reorganization and pool transaction.
+    size_t sequence() const;
+
+    /// Count a query of the key and copy its cached records at or above the
+    /// height (and unconfirmed), false if not cached.
+    bool get(system::chain::payment_record::list& out,
+        const system::hash_digest& key, size_t from_height);
+
+    /// True if the full history of the key would be admitted if read.
+    bool admissible(const system::hash_digest& key) const;
+
+    /// Offer the full history of the key read at the sequence for admission,
+    /// refused if a block or a pool transaction of the key has since been
+    /// announced.
+    bool put(const system::hash_digest& key,
+        const system::chain::payment_record::list& records, size_t sequence);
+
+    /// Evict keys affected by the fork and append the incoming blocks.
+    void reorganize(size_t fork_height,
+        const system::block_const_ptr_list& incoming);
+
+    /// Append an unconfirmed transaction.
+    void notify(const system::chain::transaction& tx);
+
+private:
+    typedef std::list<system::hash_digest> lru_list;
+    typedef std::unordered_map<system::hash_digest, size_t> sequence_map;
+
+    struct entry
+    {
+        system::chain::payment_record::list records;
+
+        // The block count at the announcement of each unconfirmed tx.
+        sequence_map unconfirmed;
+        lru_list::iterator position;
+
+        // Set by queries (under shared lock), applied by promote.
+        std::atomic<bool> referenced;
+    };
+
+    typedef std::unordered_map<system::hash_digest, entry> entry_map;
+    typedef std::unordered_map<uint64_t, system::hash_digest> output_map;
+
+    static size_t cost(size_t records);
+
+    // Frequency sketch.
+    void increment(const system::hash_digest& key);
+    size_t frequency(const system::hash_digest& key) const;
+
+    // Call under unique lock.
+    void add_outputs(const system::hash_digest& key,
+        const system::chain::payment_record::list& records);
+    void append(size_t height, const system::chain::transaction& tx);
+    void expire(const system::block_const_ptr_list& incoming);
+    void promote();
+    void shrink();
+    bool admit(const system::hash_digest& key, size_t required);
+    void evict(entry_map::iterator it);
+
+    // These are thread safe.
+    const size_t budget_;
+    std::atomic<size_t> hits_;
+    std::atomic<size_t> misses_;
+    std::atomic<size_t> admissions_;
+    std::atomic<size_t> rejections_;
+    std::atomic<size_t> samples_;
+    std::vector<std::atomic<uint8_t>> sketch_;
+
+    // These are protected by mutex.
+    size_t sequence_;
+    size_t reorganized_;
+    size_t blocks_;
+    size_t size_;
+    entry_map entries_;
+    output_map outputs_;
+    lru_list recency_;
+    key_journal announced_;
+    mutable system::shared_mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
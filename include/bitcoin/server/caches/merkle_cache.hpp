@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_CACHES_MERKLE_CACHE_HPP
+#define LIBBITCOIN_SERVER_CACHES_MERKLE_CACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// The merkle tree levels of recently confirmed and recently queried blocks,
+// by height, up to a number of blocks with least recently used eviction.
+// Incoming blocks are cached as they are announced and trees above a
+// reorganization's fork point are dropped.
+class BCS_API merkle_cache
+{
+public:
+    /// Tree levels from the transaction hashes (first) to the root (last).
+    typedef std::vector<system::hash_list> level_list;
+
+    /// Compute the tree levels of the transaction hashes.
+    static level_list to_levels(const system::hash_list& hashes);
+
+    /// The sibling hashes from the position to the root (excluded).
+    static system::hash_list to_branch(const level_list& levels,
+        size_t position);
+
+    /// Construct an empty cache of up to limit blocks (zero disables).
+    merkle_cache(size_t limit);
+
+    /// Changes with each block reorganization.
+    size_t sequence() const;
+
+    /// The branch of the position in the block at the height, false if not
+    /// cached or the position is out of range.
+    bool get_branch(system::hash_list& out, size_t height, size_t position);
+
+    /// Cache the tree of the block at the height read at the sequence.
+    bool put(size_t height, const level_list& levels, size_t sequence);
+
+    /// Drop trees above the fork point and cache the incoming blocks.
+    void reorganize(size_t fork_height,
+        const system::block_const_ptr_list& incoming);
+
+private:
+    typedef std::list<size_t> lru_list;
+
+    struct entry
+    {
+        level_list levels;
+        lru_list::iterator position;
+    };
+
+    typedef std::unordered_map<size_t, entry> entry_map;
+
+    // Call under unique lock.
+    void insert(size_t height, const level_list& levels);
+
+    // This is thread safe.
+    const size_t limit_;
+
+    // These are protected by mutex.
+    size_t sequence_;
+    entry_map entries_;
+    lru_list recency_;
+    mutable system::shared_mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_CACHES_REORG_JOURNAL_HPP
+#define LIBBITCOIN_SERVER_CACHES_REORG_JOURNAL_HPP
+
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/blockchain.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// The history entries removed by recent block reorganizations, by payment
+// key. A sync point more than depth blocks below the top cannot be served
+// incrementally. A reorganization is discarded once its highest outgoing
+// height is more than depth blocks below the top, so that no sync point that
+// can be served predates the discarded reorganization. Spends are keyed by
+// the previous outputs cached by validation or by the outputs of the outgoing
+// blocks, and a sync point that predates a reorganization with a spend that
+// is keyed by neither cannot be served incrementally.
+class BCS_API reorg_journal
+{
+public:
+    struct removal
+    {
+        system::hash_digest tx_hash;
+        size_t height;
+    };
+
+    typedef std::vector<removal> removal_list;
+
+    /// Construct an empty journal of depth blocks below the top (zero
+    /// disables).
+    reorg_journal(size_t depth);
+
+    /// Set the confirmed top from the store.
+    bool initialize(const bc::blockchain::fast_chain& chain);
+
+    /// Record the history entries of the outgoing blocks.
+    void reorganize(size_t fork_height,
+        const system::block_const_ptr_list& incoming,
+        const system::block_const_ptr_list& outgoing);
+
+    /// Append the removals of the key that may have been seen at a sync
+    /// height, and set from to the height above which the history must be
+    /// resent. Returns false if the sync height is too old to be served.
+    bool removed(removal_list& out, size_t& from,
+        const system::hash_digest& key, size_t sync_height) const;
+
+private:
+    typedef std::unordered_multimap<system::hash_digest, removal> removal_map;
+
+    // Not complete if a spend of an outgoing block was not keyed.
+    struct reorganization
+    {
+        size_t fork_height;
+        size_t outgoing_height;
+        bool complete;
+        removal_map removals;
+    };
+
+    const size_t depth_;
+
+    // These are protected by mutex.
+    size_t top_;
+    std::deque<reorganization> reorganizations_;
+    mutable system::shared_mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -22,9 +22,13 @@
 #include <cstddef>
 #include <cstdint>
 #include <bitcoin/blockchain.hpp>
+#include <bitcoin/server/caches/balance_cache.hpp>
+#include <bitcoin/server/caches/reorg_journal.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/messages/message.hpp>
 #include <bitcoin/server/server_node.hpp>
+#include <bitcoin/server/utility/filter_matcher.hpp>
+#include <bitcoin/server/utility/transaction_batch.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -39,6 +43,30 @@ public:
     static void fetch_history4(server_node& node,
         const message& request, send_handler handler);
 
+    /// Fetch the history of a payment address, optionally with transactions.
+    static void fetch_history5(server_node& node,
+        const message& request, send_handler handler);
+
+    /// Fetch the history of a payment address in the compact encoding.
+    static void fetch_history6(server_node& node,
+        const message& request, send_handler handler);
+
+    /// Fetch the unspent outputs of a payment address (including pool spends).
+    static void fetch_unspent(server_node& node,
+        const message& request, send_handler handler);
+
+    /// Fetch the aggregate balance of a payment address (including pool).
+    static void fetch_balance(server_node& node,
+        const message& request, send_handler handler);
+
+    /// Fetch a digest of the history of a payment address (including pool).
+    static void fetch_history_status(server_node& node,
+        const message& request, send_handler handler);
+
+    /// Fetch the changes to the history of a payment address since a sync.
+    static void fetch_history_delta(server_node& node,
+        const message& request, send_handler handler);
+
     /// Fetch a transaction from the blockchain by its hash.
     static void fetch_transaction(server_node& node,
         const message& request, send_handler handler);
@@ -47,6 +75,14 @@ public:
     static void fetch_transaction2(server_node& node,
         const message& request, send_handler handler);
 
+    /// Fetch a list of transactions with witness from the blockchain.
+    static void fetch_transactions(server_node& node,
+        const message& request, send_handler handler);
+
+    /// Fetch a transaction with the previous output of each of its inputs.
+    static void fetch_transaction_with_prevouts(server_node& node,
+        const message& request, send_handler handler);
+
     /// Fetch the current height of the blockchain.
     static void fetch_last_height(server_node& node,
         const message& request, send_handler handler);
@@ -59,6 +95,14 @@ public:
     static void fetch_block_header(server_node& node,
         const message& request, send_handler handler);
 
+    /// Fetch up to 2000 consecutive block headers from a start height.
+    static void fetch_block_headers(server_node& node,
+        const message& request, send_handler handler);
+
+    /// Fetch a window of consecutive blocks as one response per block.
+    static void fetch_block_range(server_node& node,
+        const message& request, send_handler handler);
+
     /// Fetch tx hashes of block by hash or height (conditional serialization).
     static void fetch_block_transaction_hashes(server_node& node,
         const message& request, send_handler handler);
@@ -67,6 +111,14 @@ public:
     static void fetch_compact_filter(server_node& node,
         const message& request, send_handler handler);
 
+    /// Fetch compact filters with their headers by start height and stop hash.
+    static void fetch_compact_filters(server_node& node,
+        const message& request, send_handler handler);
+
+    /// Fetch the heights in a range whose basic filters match any element.
+    static void match_filters(server_node& node,
+        const message& request, send_handler handler);
+
     /// Fetch compact filter checkpoint ending in block by hash.
     static void fetch_compact_filter_checkpoint(server_node& node,
         const message& request, send_handler handler);
@@ -75,6 +127,10 @@ public:
     static void fetch_compact_filter_headers(server_node& node,
         const message& request, send_handler handler);
 
+    /// Fetch the merkle branch of a confirmed transaction.
+    static void fetch_merkle_proof(server_node& node,
+        const message& request, send_handler handler);
+
     /// Fetch the block index of a transaction and the height of its block.
     static void fetch_transaction_index(server_node& node,
         const message& request, send_handler handler);
@@ -83,6 +139,10 @@ public:
     static void fetch_spend(server_node& node,
         const message& request, send_handler handler);
 
+    /// Fetch the inpoints spending the outputs of a transaction or points.
+    static void fetch_spends(server_node& node,
+        const message& request, send_handler handler);
+
     /// Fetch the height of a block by its hash.
     static void fetch_block_height(server_node& node,
         const message& request, send_handler handler);
@@ -100,10 +160,69 @@ private:
         const system::chain::payment_record::list& payments,
         const message& request, send_handler handler);
 
+    static void history6_fetched(const system::code& ec,
+        const system::chain::payment_record::list& payments,
+        const message& request, send_handler handler);
+
+    static void history5_fetched(const system::code& ec,
+        const system::chain::payment_record::list& payments,
+        server_node& node, const message& request, send_handler handler,
+        bool include_transactions);
+
+    static void history_transactions_fetched(
+        const transaction_batch::code_list& codes,
+        const transaction_batch::transaction_list& transactions,
+        const system::hash_list& hashes, const system::data_chunk& records,
+        const message& request, send_handler handler);
+
+    static void unspent_history_fetched(const system::code& ec,
+        const system::chain::payment_record::list& payments,
+        server_node& node, const message& request, send_handler handler,
+        size_t min_conf);
+
+    static void unspent_transactions_fetched(
+        const transaction_batch::code_list& codes,
+        const transaction_batch::transaction_list& transactions,
+        const system::hash_list& hashes,
+        const system::chain::payment_record::list& unspent,
+        const message& request, send_handler handler);
+
+    typedef void(*aggregate_handler)(const balance_cache::balance&,
+        const message&, send_handler);
+
+    static void fetch_aggregate(server_node& node, const message& request,
+        send_handler handler, aggregate_handler reply);
+
+    static void aggregate_fetched(const system::code& ec,
+        const balance_cache::balance& balance, const message& request,
+        send_handler handler, aggregate_handler reply);
+
+    static void balance_fetched(const balance_cache::balance& balance,
+        const message& request, send_handler handler);
+
+    static void status_fetched(const balance_cache::balance& balance,
+        const message& request, send_handler handler);
+
+    static void delta_status_fetched(const system::code& ec,
+        const balance_cache::balance& balance, server_node& node,
+        const message& request, send_handler handler,
+        const system::hash_digest& key, size_t sync_height,
+        const system::hash_digest& sync_status);
+
+    static void delta_history_fetched(const system::code& ec,
+        const system::chain::payment_record::list& payments,
+        const message& request, send_handler handler,
+        const system::hash_digest& status, uint8_t flags, size_t from,
+        const reorg_journal::removal_list& removals);
+
     static void transaction_fetched(const system::code& ec,
         system::transaction_const_ptr tx, size_t, size_t,
         const message& request, send_handler handler);
 
+    static void transaction_with_prevouts_fetched(const system::code& ec,
+        system::transaction_const_ptr tx, size_t, size_t, server_node& node,
+        const message& request, send_handler handler);
+
     static void last_height_fetched(const system::code& ec, size_t last_height,
         const message& request, send_handler handler);
 
@@ -133,6 +252,11 @@ private:
         system::compact_filter_ptr response, size_t, const message& request,
         send_handler handler);
 
+    static void compact_filter_range_fetched(const system::code& ec,
+        system::compact_filter_headers_ptr headers, server_node& node,
+        uint8_t filter_type, size_t start_height, const message& request,
+        send_handler handler);
+
     static void fetch_compact_filter_headers_by_hash(server_node& node,
         const message& request, send_handler handler);
 
@@ -161,6 +285,19 @@ private:
         system::merkle_block_ptr block, size_t height, const message& request,
         send_handler handler);
 
+    static void merkle_position_fetched(const system::code& ec,
+        size_t tx_position, size_t block_height, server_node& node,
+        size_t sequence, const message& request, send_handler handler);
+
+    static void merkle_tree_fetched(const system::code& ec,
+        system::merkle_block_ptr block, size_t height, server_node& node,
+        size_t tx_position, size_t sequence, const message& request,
+        send_handler handler);
+
+    static void send_merkle_proof(const system::hash_list& branch,
+        size_t tx_position, size_t block_height, const message& request,
+        send_handler handler);
+
     static void transaction_index_fetched(const system::code& ec,
         size_t tx_position, size_t block_height, const message& request,
         send_handler handler);
@@ -169,6 +306,10 @@ private:
         const system::chain::input_point& inpoint, const message& request,
         send_handler handler);
 
+    static void spends_transaction_fetched(const system::code& ec,
+        system::transaction_const_ptr tx, size_t, size_t, server_node& node,
+        const message& request, send_handler handler);
+
     static void block_height_fetched(const system::code& ec,
         size_t block_height, const message& request, send_handler handler);
 
@@ -35,6 +35,10 @@ public:
     /// Fetch the server's version.
     static void version(server_node& node, const message& request,
         send_handler handler);
+
+    /// Fetch the notification queue metrics of the websocket endpoints.
+    static void fetch_websocket_metrics(server_node& node,
+        const message& request, send_handler handler);
 };
 
 } // namespace server
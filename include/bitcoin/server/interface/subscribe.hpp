@@ -19,6 +19,8 @@
 #ifndef LIBBITCOIN_SERVER_SUBSCRIBE_HPP
 #define LIBBITCOIN_SERVER_SUBSCRIBE_HPP
 
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/caches/balance_cache.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/messages/message.hpp>
 #include <bitcoin/server/server_node.hpp>
@@ -34,6 +36,11 @@ public:
     /// Subscribe to payment address notifications by key.
     static void key(server_node& node, const message& request,
         send_handler handler);
+
+private:
+    static void status_fetched(const system::code& ec,
+        const balance_cache::balance& balance, const message& request,
+        send_handler handler);
 };
 
 } // namespace server
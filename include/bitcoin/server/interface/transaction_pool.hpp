@@ -40,6 +40,10 @@ public:
     static void fetch_transaction2(server_node& node, const message& request,
         send_handler handler);
 
+    /// Fetch a list of transactions with witness from the pool or blockchain.
+    static void fetch_transactions(server_node& node, const message& request,
+        send_handler handler);
+
     /// Save to tx pool and announce to all connected peers.
     static void broadcast(server_node& node, const message& request,
         send_handler handler);
@@ -19,7 +19,9 @@
 #ifndef LIBBITCOIN_SERVER_MESSAGE
 #define LIBBITCOIN_SERVER_MESSAGE
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <bitcoin/protocol.hpp>
 #include <bitcoin/server/define.hpp>
@@ -32,6 +34,10 @@ namespace server {
 class BCS_API message
 {
 public:
+    /// Validate the command frame and request size of a received message.
+    typedef std::function<system::code(const system::data_chunk& command,
+        size_t size)> validator;
+
     static system::data_chunk to_bytes(const system::code& ec);
 
     // Constructors.
@@ -75,8 +81,10 @@ public:
     // Send/Receive.
     //-------------------------------------------------------------------------
 
-    /// Receive a message via the socket.
-    system::code receive(bc::protocol::zmq::socket& socket);
+    /// Receive a message via the socket, the command is validated in its
+    /// frame before it is decoded.
+    system::code receive(bc::protocol::zmq::socket& socket,
+        const validator& validate);
 
     /// Send the message via the socket.
     system::code send(bc::protocol::zmq::socket& socket) const;
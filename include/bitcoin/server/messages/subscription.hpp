@@ -39,11 +39,15 @@ public:
     subscription(const subscription& other);
 
     /// Construct subscription state from an existing route.
-    subscription(const route& return_route, uint32_t id, time_t now);
+    subscription(const route& return_route, uint32_t id, time_t now,
+        bool status);
 
     /// Arbitrary caller data, returned to caller on each notification.
     uint32_t id() const;
 
+    /// Notifications include the history status of the subscribed key.
+    bool status() const;
+
     /// Last subscription time, used for expirations.
     time_t updated() const;
 
@@ -75,6 +79,7 @@ public:
 
 protected:
     uint32_t id_;
+    bool status_;
     mutable std::atomic<time_t> updated_;
     mutable std::atomic<uint16_t> sequence_;
 };
@@ -19,10 +19,19 @@
 #ifndef LIBBITCOIN_SERVER_SERVER_NODE_HPP
 #define LIBBITCOIN_SERVER_SERVER_NODE_HPP
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
 #include <bitcoin/node.hpp>
 #include <bitcoin/protocol.hpp>
+#include <bitcoin/server/caches/balance_cache.hpp>
+#include <bitcoin/server/caches/filter_cache.hpp>
+#include <bitcoin/server/caches/header_cache.hpp>
+#include <bitcoin/server/caches/history_cache.hpp>
+#include <bitcoin/server/caches/merkle_cache.hpp>
+#include <bitcoin/server/caches/reorg_journal.hpp>
 #include <bitcoin/server/configuration.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/messages/message.hpp>
@@ -31,6 +40,7 @@
 #include <bitcoin/server/services/heartbeat_service.hpp>
 #include <bitcoin/server/services/query_service.hpp>
 #include <bitcoin/server/services/transaction_service.hpp>
+#include <bitcoin/server/utility/submission_queue.hpp>
 #include <bitcoin/server/web/block_socket.hpp>
 #include <bitcoin/server/web/heartbeat_socket.hpp>
 #include <bitcoin/server/web/query_socket.hpp>
@@ -48,6 +58,10 @@ class BCS_API server_node
 {
 public:
     typedef std::shared_ptr<server_node> ptr;
+    typedef std::function<void(const system::code&,
+        const balance_cache::balance&)> balance_handler;
+    typedef std::function<void(const system::code&,
+        const system::chain::payment_record::list&)> history_handler;
 
     /// Construct a server node.
     server_node(const configuration& configuration);
@@ -67,6 +81,43 @@ public:
     /// Server configuration settings.
     virtual const bc::server::settings& server_settings() const;
 
+    /// The confirmed header chain, empty if not enabled.
+    virtual const header_cache& headers() const;
+
+    /// True if the header cache is enabled and loaded to the confirmed top.
+    virtual bool headers_loaded() const;
+
+    /// The compact filters of the most recent blocks, empty if not enabled.
+    virtual const filter_cache& filters() const;
+
+    /// The merkle trees of recent and recently queried blocks.
+    virtual merkle_cache& merkle_trees();
+
+    /// The histories of frequently queried payment keys.
+    virtual history_cache& histories();
+
+    /// The history entries removed by recent reorganizations.
+    virtual const reorg_journal& reorganizations() const;
+
+    /// The balances of recently queried payment keys.
+    virtual balance_cache& balances();
+
+    /// The queue of client transaction submissions to the organizer.
+    virtual submission_queue& submissions();
+
+    /// The notification queue metrics of each started websocket block and
+    /// transaction endpoint.
+    virtual session_socket::metrics::list websocket_metrics() const;
+
+    /// Fetch the history of the payment key at or above the height (and
+    /// unconfirmed), from the history cache if cached.
+    virtual void fetch_history(const system::hash_digest& key,
+        size_t from_height, history_handler handler);
+
+    /// Fetch the balance of the payment key, caching it if not cached.
+    virtual void fetch_balance(const system::hash_digest& key,
+        balance_handler handler);
+
     // Run sequence.
     // ------------------------------------------------------------------------
 
@@ -90,15 +141,80 @@ public:
     // ------------------------------------------------------------------------
 
     virtual system::code subscribe_key(const message& request,
-        system::hash_digest&& key, bool unsubscribe);
+        system::hash_digest&& key, bool unsubscribe, bool status);
 
     virtual system::code subscribe_stealth(const message& request,
         system::binary&& prefix_filter, bool unsubscribe);
 
 private:
+    // A batch of concurrent header reads, pushed in height order once all
+    // have completed. Each read sets only its own index.
+    struct header_batch
+    {
+        size_t start;
+        std::atomic<size_t> pending;
+        std::vector<system::code> codes;
+        std::vector<system::header_const_ptr> headers;
+    };
+
+    typedef std::shared_ptr<header_batch> header_batch_ptr;
+
     void handle_running(const system::code& ec, result_handler handler);
+    void organize_submission(system::transaction_const_ptr tx,
+        submission_queue::result_handler handler);
+
+    bool handle_headers(const system::code& ec, size_t fork_height,
+        system::block_const_ptr_list_const_ptr incoming,
+        system::block_const_ptr_list_const_ptr outgoing);
+    void load_headers(size_t start);
+    void handle_header(const system::code& ec,
+        system::header_const_ptr header, size_t index,
+        header_batch_ptr batch);
+    void push_headers(header_batch_ptr batch);
+    bool handle_filters(const system::code& ec, size_t fork_height,
+        system::block_const_ptr_list_const_ptr incoming,
+        system::block_const_ptr_list_const_ptr outgoing);
+    bool handle_merkle_trees(const system::code& ec, size_t fork_height,
+        system::block_const_ptr_list_const_ptr incoming,
+        system::block_const_ptr_list_const_ptr outgoing);
+    bool handle_histories(const system::code& ec, size_t fork_height,
+        system::block_const_ptr_list_const_ptr incoming,
+        system::block_const_ptr_list_const_ptr outgoing);
+    bool handle_history_transaction(const system::code& ec,
+        system::transaction_const_ptr tx);
+    bool handle_reorganizations(const system::code& ec, size_t fork_height,
+        system::block_const_ptr_list_const_ptr incoming,
+        system::block_const_ptr_list_const_ptr outgoing);
+    bool handle_balances(const system::code& ec, size_t fork_height,
+        system::block_const_ptr_list_const_ptr incoming,
+        system::block_const_ptr_list_const_ptr outgoing);
+    bool handle_balance_transaction(const system::code& ec,
+        system::transaction_const_ptr tx);
+    void load_filters(size_t generation, size_t start, size_t stop);
+    void handle_filter_headers(const system::code& ec,
+        system::compact_filter_headers_ptr headers, size_t generation,
+        size_t start);
+    void load_filter(size_t generation, size_t height,
+        std::shared_ptr<const system::hash_list> headers, size_t start);
+    void handle_filter(const system::code& ec,
+        system::compact_filter_ptr filter, size_t height, size_t generation,
+        std::shared_ptr<const system::hash_list> headers, size_t start);
+    void handle_history(const system::code& ec,
+        const system::chain::payment_record::list& payments,
+        const system::hash_digest& key, size_t from_height, size_t sequence,
+        history_handler handler);
+    void handle_balance_history(const system::code& ec,
+        const system::chain::payment_record::list& payments,
+        const system::hash_digest& key, size_t sequence,
+        balance_handler handler);
 
     bool start_services();
+    bool start_header_cache();
+    bool start_filter_cache();
+    bool start_merkle_cache();
+    bool start_balance_cache();
+    bool start_reorg_journal();
+    bool start_history_cache();
     bool start_authenticator();
     bool start_query_services();
     bool start_heartbeat_services();
@@ -110,6 +226,14 @@ private:
     const configuration& configuration_;
 
     // These are thread safe.
+    header_cache headers_;
+    std::atomic<bool> loading_headers_;
+    filter_cache filters_;
+    merkle_cache merkle_trees_;
+    balance_cache balances_;
+    reorg_journal reorganizations_;
+    history_cache histories_;
+    submission_queue submissions_;
     authenticator authenticator_;
     query_service secure_query_service_;
     query_service public_query_service_;
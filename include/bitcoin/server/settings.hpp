@@ -58,6 +58,13 @@ public:
     uint32_t heartbeat_service_seconds;
     bool block_service_enabled;
     bool transaction_service_enabled;
+    bool header_cache_enabled;
+    uint32_t filter_cache_limit;
+    uint32_t merkle_cache_limit;
+    uint32_t balance_cache_limit;
+    uint32_t history_cache_bytes;
+    uint32_t reorg_journal_depth;
+    uint32_t query_compression_threshold;
     system::config::authority::list client_addresses;
     system::config::authority::list blacklists;
 
@@ -73,6 +80,10 @@ public:
     system::config::endpoint websockets_public_transaction_endpoint;
 
     bool websockets_enabled;
+    uint16_t websockets_compression_level;
+    uint32_t websockets_queue_limit;
+    bool websockets_disconnect_slow;
+    uint16_t websockets_threads;
 
     /// [zeromq]
     system::config::endpoint zeromq_secure_query_endpoint;
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_UTILITY_COMPRESSOR_HPP
+#define LIBBITCOIN_SERVER_UTILITY_COMPRESSOR_HPP
+
+#include <cstddef>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// Raw DEFLATE (RFC 1951) without zlib header or trailer. This is an in-band
+// encoding of binary websocket frames, opted into by session.compression (and
+// of zeromq ".deflate" responses). It is not the negotiated permessage-deflate
+// extension (RFC 7692), so clients must inflate the payload explicitly. There
+// is no context takeover, so a compressed message can be shared by any number
+// of recipients.
+class BCS_API compressor
+{
+public:
+    /// Construct a compressor of the given zlib level (1..9).
+    compressor(int level);
+
+    /// Compress the data, false on failure.
+    bool deflate(system::data_chunk& out,
+        const system::data_chunk& data) const;
+
+    /// Decompress the data, false on failure.
+    bool inflate(system::data_chunk& out,
+        const system::data_chunk& data) const;
+
+private:
+    const int level_;
+};
+
+// This class is not thread safe.
+// Raw DEFLATE as above, from a single zlib stream that is reset between
+// messages, so its state is allocated once rather than for each message.
+class BCS_API deflater
+{
+public:
+    /// Construct a deflater of the given zlib level (1..9).
+    deflater(int level);
+
+    /// Compress the data, false on failure.
+    bool deflate(system::data_chunk& out, const system::data_chunk& data);
+
+private:
+    const int level_;
+
+    // Copies of the filter share its stream.
+    boost::iostreams::zlib_compressor filter_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
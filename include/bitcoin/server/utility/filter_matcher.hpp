@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_UTILITY_FILTER_MATCHER_HPP
+#define LIBBITCOIN_SERVER_UTILITY_FILTER_MATCHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// Tests a set of elements (output scripts) against BIP158 basic filters. The
+// elements are SipHash-2-4 keyed by each block hash and mapped into the
+// filter range in one batch, and are then merged against the decoded
+// Golomb-Rice set, so each filter is decoded at most once.
+class BCS_API filter_matcher
+{
+public:
+    /// The Golomb-Rice parameter of basic filters.
+    static const uint8_t golomb_bits;
+
+    /// The inverse false positive rate of basic filters.
+    static const uint64_t target_rate;
+
+    /// Construct a matcher of the element set.
+    filter_matcher(system::data_stack&& elements);
+
+    /// True if any element is a member of the filter (with the BIP158 false
+    /// positive rate). The filter is [count:varint][golomb-rice set].
+    bool match(const system::hash_digest& block_hash,
+        const system::data_chunk& filter) const;
+
+    /// SipHash-2-4 of the data with the 128 bit key.
+    static uint64_t siphash(uint64_t k0, uint64_t k1,
+        const system::data_chunk& data);
+
+private:
+    typedef std::vector<uint64_t> value_list;
+
+    value_list hashed_set(const system::hash_digest& block_hash,
+        uint64_t range) const;
+
+    const system::data_stack elements_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_UTILITY_HISTORY_ENCODER_HPP
+#define LIBBITCOIN_SERVER_UTILITY_HISTORY_ENCODER_HPP
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// The compact history encoding of fetch_history6. Records are ordered by
+// height (unconfirmed last), each transaction hash is written once and
+// referenced by its ordinal, and confirmed heights are the delta from the
+// preceding confirmed record. Spends carry the point checksum.
+// [ hash_count:varint ]
+// [ hash:32 ]...
+// [ record_count:varint ]
+// [[ flags:1 ][ ordinal:varint ][ index:varint ][ height_delta:varint ]
+//  [ value:varint | checksum:8 ]]...
+// flags bit 0: output, bit 1: unconfirmed (no height delta).
+class BCS_API history_encoder
+{
+public:
+    /// Flag of an output record.
+    static const uint8_t record_output;
+
+    /// Flag of an unconfirmed record.
+    static const uint8_t record_unconfirmed;
+
+    /// The encoding of the records, preceded by prefix zeroed bytes.
+    static system::data_chunk encode(
+        const system::chain::payment_record::list& payments,
+        size_t prefix=0);
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_UTILITY_KEY_JOURNAL_HPP
+#define LIBBITCOIN_SERVER_UTILITY_KEY_JOURNAL_HPP
+
+#include <cstddef>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is not thread safe.
+// The payment keys of recently announced pool transactions by the sequence
+// of their announcement, so that a history read of a key at an earlier
+// sequence can be recognized as possibly incomplete. Inputs are keyed by the
+// previous outputs cached by validation, which pool transactions carry. A
+// transaction with an input that does not carry one changes all keys.
+class BCS_API key_journal
+{
+public:
+    /// Construct a journal of up to limit key announcements.
+    key_journal(size_t limit);
+
+    /// Record the keys of the pool transaction at the sequence.
+    void record(const system::chain::transaction& tx, size_t sequence);
+
+    /// True if the key may have been announced after the sequence, including
+    /// if announcements since the sequence have been dropped from the journal.
+    bool changed(const system::hash_digest& key, size_t sequence) const;
+
+private:
+    typedef std::pair<system::hash_digest, size_t> announcement;
+
+    void record(const system::hash_digest& key, size_t sequence);
+
+    const size_t limit_;
+    size_t horizon_;
+    std::unordered_map<system::hash_digest, size_t> latest_;
+    std::deque<announcement> announcements_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_UTILITY_PAYMENT_KEY_HPP
+#define LIBBITCOIN_SERVER_UTILITY_PAYMENT_KEY_HPP
+
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// The payment key of an output script, as indexed by the store (the sha256
+// of the script without its length prefix).
+class BCS_API payment_key
+{
+public:
+    /// The payment key (script hash) of an output script.
+    static system::hash_digest to_key(const system::chain::script& script);
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_UTILITY_SUBMISSION_QUEUE_HPP
+#define LIBBITCOIN_SERVER_UTILITY_SUBMISSION_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+// This class is thread safe.
+// Transactions submitted by clients are queued and fed to the organizer one
+// batch at a time, each completing its own request. Submissions arriving
+// while a batch is organized form the next batch, so a burst occupies one
+// organization at a time rather than a blocked thread per transaction.
+// Transactions are deserialized by the submitting query worker threads, in
+// parallel, before being queued. Validation is performed by the organizer,
+// which is serial. Completions that occur within the organize call (such as
+// rejections) continue the drain loop rather than nesting on the stack.
+class BCS_API submission_queue
+{
+public:
+    typedef std::function<void(const system::code&)> result_handler;
+    typedef std::function<void(system::transaction_const_ptr,
+        result_handler)> organizer;
+
+    /// Construct an empty queue feeding the organizer.
+    submission_queue(organizer organize);
+
+    /// The number of transactions submitted.
+    size_t submitted() const;
+
+    /// The number of batches organized.
+    size_t batches() const;
+
+    /// Queue the transaction for organization (or simulation).
+    void submit(system::transaction_const_ptr tx, result_handler handler);
+
+private:
+    struct submission
+    {
+        system::transaction_const_ptr tx;
+        result_handler handler;
+    };
+
+    typedef std::vector<submission> submission_list;
+
+    bool next(submission& out);
+    void drain();
+    void handle_organized(const system::code& ec, result_handler handler);
+
+    // These are thread safe.
+    const organizer organize_;
+    std::atomic<size_t> submitted_;
+    std::atomic<size_t> batches_;
+
+    // These are protected by mutex.
+    bool organizing_;
+    bool calling_;
+    bool completed_;
+    size_t index_;
+    submission_list batch_;
+    submission_list pending_;
+    std::mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_UTILITY_TRANSACTION_BATCH_HPP
+#define LIBBITCOIN_SERVER_UTILITY_TRANSACTION_BATCH_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/messages/message.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+class server_node;
+
+// This class is thread safe.
+// Fetches a list of transactions with concurrent store reads, at most
+// maximum_hashes outstanding, and responds once all have completed, with the
+// status and data of each in request order.
+class BCS_API transaction_batch
+  : public std::enable_shared_from_this<transaction_batch>
+{
+public:
+    typedef std::shared_ptr<transaction_batch> ptr;
+    typedef std::vector<system::code> code_list;
+    typedef std::vector<system::transaction_const_ptr> transaction_list;
+    typedef std::function<void(const code_list&, const transaction_list&,
+        const system::hash_list&)> batch_handler;
+
+    /// The maximum number of hashes accepted in one request, and of store
+    /// reads outstanding for any one batch.
+    static const size_t maximum_hashes;
+
+    /// Parse the request and fetch the listed transactions.
+    static void fetch(server_node& node, const message& request,
+        send_handler handler, bool require_confirmed, bool witness);
+
+    /// Fetch the transactions, results are in the order of the hashes, which
+    /// are returned to the handler.
+    static void fetch(server_node& node, system::hash_list&& hashes,
+        bool require_confirmed, bool witness, batch_handler handler);
+
+    /// Use fetch.
+    transaction_batch(server_node& node, system::hash_list&& hashes,
+        bool require_confirmed, bool witness, batch_handler handler);
+
+private:
+    typedef std::vector<size_t> indexes;
+
+    static void batch_fetched(const code_list& codes,
+        const transaction_list& transactions, const message& request,
+        send_handler handler);
+
+    void start();
+    indexes next_indexes();
+    void fetch(const indexes& values);
+    void handle_fetched(const system::code& ec,
+        system::transaction_const_ptr tx, size_t index);
+
+    server_node& node_;
+    const system::hash_list hashes_;
+    const bool require_confirmed_;
+    const bool witness_;
+    const batch_handler handler_;
+
+    // These are protected by mutex.
+    size_t next_;
+    size_t pending_;
+    code_list codes_;
+    transaction_list transactions_;
+    std::mutex mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -22,6 +22,7 @@
 #include <bitcoin/protocol.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/settings.hpp>
+#include <bitcoin/server/web/session_socket.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -31,7 +32,7 @@ class server_node;
 // This class is thread safe.
 // Subscribe to block acceptances from a dedicated socket endpoint.
 class BCS_API block_socket
-  : public bc::protocol::http::socket
+  : public session_socket
 {
 public:
     typedef std::shared_ptr<block_socket> ptr;
@@ -49,6 +50,8 @@ protected:
 
 private:
     bool handle_block(bc::protocol::zmq::socket& subscriber);
+    void publish_confirmations(const system::data_chunk& block_data,
+        uint32_t height, uint16_t sequence);
 
     const bc::server::settings& settings_;
     const bc::protocol::settings& protocol_settings_;
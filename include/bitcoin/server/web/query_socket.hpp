@@ -19,9 +19,16 @@
 #ifndef LIBBITCOIN_SERVER_WEB_QUERY_SOCKET_HPP
 #define LIBBITCOIN_SERVER_WEB_QUERY_SOCKET_HPP
 
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <bitcoin/protocol.hpp>
+#include <bitcoin/system.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/settings.hpp>
+#include <bitcoin/server/web/session_socket.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -31,8 +38,18 @@ class server_node;
 // This class is thread safe.
 // Submit queries and address subscriptions and receive address
 // notifications on a dedicated socket endpoint.
+// Immutable chain data is also served by HTTP GET, with an optional
+// ".json" (default), ".bin" or ".hex" suffix selecting the body format:
+// /block/<hash>, /tx/<hash> and /header/<height>.
+// Queries of a binary session are answered in binary frames of
+// [id:4][code:4][response], the undecoded zeromq response. These are
+// dispatched here since the base only decodes successful responses.
+// HTTP and websocket framing is parsed by the single websocket thread (the
+// reactor, within libbitcoin-protocol). If configured, the responses of other
+// sessions are decoded and rendered to JSON by a pool of threads behind the
+// reactor, which then only writes the rendered response.
 class BCS_API query_socket
-  : public bc::protocol::http::socket
+  : public session_socket
 {
 public:
     typedef std::shared_ptr<query_socket> ptr;
@@ -47,9 +64,19 @@ protected:
 
     virtual bool start_websocket_handler() override;
 
+    // Serve chain data GET requests, others are handled by the base.
+    virtual bool handle_http_request(connection_ptr connection,
+        const bc::protocol::http::http_request& request) override;
+
     // Initialize the query specific zmq socket.
     virtual void handle_websockets() override;
 
+    // Dispatch queries that are answered here, others to the base.
+    virtual void notify_query_work(connection_ptr connection,
+        const std::string& method, uint32_t id,
+        const std::string& parameters) override;
+    virtual void remove_connection(connection_ptr connection) override;
+
     virtual const system::config::endpoint& zeromq_endpoint() const override;
     virtual const system::config::endpoint& websocket_endpoint() const override;
     virtual const std::shared_ptr<bc::protocol::zmq::socket> service()
@@ -58,11 +85,63 @@ protected:
     const system::config::endpoint& query_endpoint() const;
 
 private:
+    enum class rest_format
+    {
+        json,
+        binary,
+        hex
+    };
+
+    // Render the JSON of a successful response payload (thread safe).
+    typedef std::function<std::string(const system::data_chunk&, uint32_t)>
+        renderer;
+
+    struct renderers
+    {
+        renderer native;
+        renderer rpc;
+    };
+
+    // A binary query has no renderer.
+    struct pending_query
+    {
+        connection_ptr connection;
+        uint32_t id;
+        renderer render;
+    };
+
+    typedef std::unordered_map<std::string, renderers> renderer_map;
+    typedef std::unordered_map<uint32_t, pending_query> pending_query_map;
+
     bool handle_query(bc::protocol::zmq::socket& dealer);
+    bool handle_pending_query(uint32_t sequence, system::data_chunk& data);
+    void render(const pending_query& query, const system::data_chunk& data);
+
+    void get_block(connection_ptr connection, const system::hash_digest& hash,
+        rest_format format, const std::string& if_none_match);
+    void get_transaction(connection_ptr connection,
+        const system::hash_digest& hash, rest_format format,
+        const std::string& if_none_match);
+    void get_header(connection_ptr connection, size_t height,
+        rest_format format, const std::string& if_none_match);
+    void send_rest(connection_ptr connection, const std::string& identity,
+        bool immutable, const system::data_chunk& data,
+        const std::string& json, rest_format format,
+        const std::string& if_none_match);
+    bool is_immutable(size_t height) const;
+
+    server_node& node_;
 
     const bc::server::settings& settings_;
     const bc::protocol::settings& protocol_settings_;
     std::shared_ptr<bc::protocol::zmq::socket> service_;
+    renderer_map renderers_;
+    system::threadpool render_pool_;
+
+    // These are protected by mutex.
+    uint32_t pending_sequence_;
+    pending_query_map pending_queries_;
+    std::mutex pending_mutex_;
 };
 
 } // namespace server
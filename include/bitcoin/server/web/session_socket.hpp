@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_SERVER_WEB_SESSION_SOCKET_HPP
+#define LIBBITCOIN_SERVER_WEB_SESSION_SOCKET_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/protocol.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/utility/compressor.hpp>
+#include <bitcoin/server/workers/notification_worker.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+class server_node;
+
+// This class is thread safe.
+// Websocket base that tracks the negotiated state of each connection, so that
+// broadcasts and responses can be framed according to each client's choice.
+// A client selects its framing by sending the "session.encoding" method with
+// a parameter of "json" (default) or "binary". The reply to the negotiation
+// is always JSON, all subsequent messages use the selected framing.
+// If enabled, a client may also restrict notifications to payment keys by
+// sending "subscribe.key" (or "unsubscribe.key") with a payment address or
+// base16 script hash parameter. A session without keys is not filtered.
+// If enabled, a client may send "session.compression" with a parameter of
+// "deflate" (or "none") to receive notifications as binary frames of raw
+// DEFLATE data. Each distinct message is compressed once per broadcast.
+// Notifications queued to a session beyond its byte limit are dropped, or
+// the session is disconnected, according to configuration. The limit applies
+// to notifications not yet passed to the connection. A connection buffers
+// writes that the client has not yet consumed within libbitcoin-protocol,
+// which does not expose that buffer, so those bytes cannot be bounded here.
+class BCS_API session_socket
+  : public bc::protocol::http::socket
+{
+public:
+    typedef std::shared_ptr<session_socket> ptr;
+
+    /// Notification queue metrics of the websocket endpoint.
+    struct metrics
+    {
+        typedef std::vector<metrics> list;
+
+        system::config::endpoint endpoint;
+        size_t sessions;
+        size_t queued;
+        size_t dropped;
+        size_t evicted;
+    };
+
+    /// Construct a session tracking socket, notifications enables filtering
+    /// and compression as configured.
+    session_socket(bc::protocol::zmq::context& context, server_node& node,
+        bool secure, bool notifications);
+
+    /// The number of notifications dropped due to slow consumption.
+    size_t dropped() const;
+
+    /// The number of sessions disconnected due to slow consumption.
+    size_t evicted() const;
+
+    /// The queue metrics of all sessions of the endpoint.
+    metrics get_metrics() const;
+
+protected:
+    typedef bc::protocol::http::connection_ptr connection_ptr;
+    typedef std::function<std::string()> json_factory;
+    typedef std::function<system::data_chunk(size_t)> item_payload_factory;
+    typedef std::function<std::string(size_t)> item_json_factory;
+    typedef notification_worker::key_set key_set;
+
+    /// The items (ascending ordinals) of a broadcast having each key.
+    typedef std::unordered_map<system::hash_digest, std::vector<size_t>>
+        key_index;
+
+    enum class encoding
+    {
+        json,
+        binary
+    };
+
+    typedef std::shared_ptr<std::atomic<size_t>> counter_ptr;
+
+    struct session
+    {
+        encoding framing;
+        bool deflated;
+        key_set filter;
+
+        // Bytes queued to the manager and not yet passed to the connection.
+        counter_ptr queued;
+        std::shared_ptr<std::atomic<bool>> evicting;
+    };
+
+    typedef std::unordered_map<connection_ptr, session> session_map;
+
+    // Session tracking, called on the websocket thread.
+    virtual void add_connection(connection_ptr connection) override;
+    virtual void remove_connection(connection_ptr connection) override;
+    virtual void notify_query_work(connection_ptr connection,
+        const std::string& method, uint32_t id,
+        const std::string& parameters) override;
+
+    /// The negotiated framing of the connection (json if unknown).
+    encoding framing(connection_ptr connection) const;
+
+    /// Queue a preformatted write to a connection from any thread.
+    void send_queued(connection_ptr connection, std::string&& data);
+
+    /// Queue a binary frame of the payload to a connection from any thread.
+    void send_queued(connection_ptr connection, system::data_chunk&& payload);
+
+    /// Send a binary frame to a connection on the websocket thread.
+    bool send_binary(connection_ptr connection,
+        const system::data_chunk& payload) const;
+
+    /// True if any session has a key filter.
+    bool filtered() const;
+
+    /// Queue the payload to each unfiltered session in its framing.
+    /// JSON is rendered (once) only if a session requires it.
+    void publish(const system::data_chunk& payload,
+        json_factory to_json);
+
+    /// Queue the payload to each filtered session matching any of the keys.
+    void publish(const key_set& keys, const system::data_chunk& payload,
+        json_factory to_json);
+
+    /// Queue each of the items to each filtered session matching any of its
+    /// keys. Session filters are looked up in the index, so the cost does not
+    /// scale with the product of items and sessions. Each item is rendered
+    /// (once) only if a session matches it.
+    void publish(const key_index& index, size_t items,
+        item_payload_factory to_payload, item_json_factory to_json);
+
+private:
+    typedef std::function<bool(const session&)> session_predicate;
+
+    // The session state required to notify it, copied from the session.
+    struct recipient
+    {
+        typedef std::vector<recipient> list;
+
+        connection_ptr connection;
+        encoding framing;
+        bool deflated;
+        counter_ptr queued;
+        std::shared_ptr<std::atomic<bool>> evicting;
+    };
+
+    static recipient to_recipient(const session_map::value_type& entry);
+
+    void publish_if(session_predicate predicate,
+        const system::data_chunk& payload, json_factory to_json);
+    void send(const recipient::list& targets,
+        const system::data_chunk& payload, json_factory to_json);
+
+    template <typename Message>
+    void enqueue(const recipient& target,
+        std::shared_ptr<const Message> message);
+
+    system::code set_framing(connection_ptr connection,
+        const std::string& parameters);
+    system::code set_filter(connection_ptr connection,
+        const std::string& parameters, bool unsubscribe);
+    system::code set_compression(connection_ptr connection,
+        const std::string& parameters);
+
+    // These are thread safe.
+    const uint32_t filter_limit_;
+    const bool compression_;
+    const compressor compressor_;
+    const size_t queue_limit_;
+    const bool disconnect_slow_;
+    std::atomic<size_t> dropped_;
+    std::atomic<size_t> evicted_;
+
+    // This is protected by mutex.
+    session_map sessions_;
+    mutable system::upgrade_mutex session_mutex_;
+};
+
+} // namespace server
+} // namespace libbitcoin
+
+#endif
@@ -22,6 +22,7 @@
 #include <bitcoin/protocol.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/settings.hpp>
+#include <bitcoin/server/web/session_socket.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -31,7 +32,7 @@ class server_node;
 // This class is thread safe.
 // Subscribe to tx acceptances into the pool from a dedicated socket endpoint.
 class BCS_API transaction_socket
-  : public bc::protocol::http::socket
+  : public session_socket
 {
 public:
     typedef std::shared_ptr<transaction_socket> ptr;
@@ -48,6 +48,10 @@ class BCS_API notification_worker
 {
 public:
     typedef std::shared_ptr<notification_worker> ptr;
+    typedef std::unordered_set<system::hash_digest> key_set;
+
+    /// The unique payment keys (script hashes) of the transaction.
+    static key_set to_keys(const system::chain::transaction& tx);
 
     /// Construct a notification worker.
     notification_worker(bc::protocol::zmq::authenticator& authenticator,
@@ -56,9 +60,9 @@ public:
     /// Start the worker.
     bool start() override;
 
-    /// Subscribe to payment key notifications.
+    /// Subscribe to payment key notifications, optionally with key status.
     virtual system::code subscribe_key(const message& request,
-        system::hash_digest&& key, bool unsubscribe);
+        system::hash_digest&& key, bool unsubscribe, bool status);
 
     /// Subscribe to stealth notifications.
     virtual system::code subscribe_stealth(const message& request,
@@ -72,7 +76,6 @@ protected:
 private:
     typedef bc::protocol::zmq::socket socket;
     typedef std::unordered_set<uint32_t> stealth_set;
-    typedef std::unordered_set<system::hash_digest> key_set;
 
     // Purge:     route.created (constant: 1).
     // Notify:    address (constant: 1).
@@ -123,6 +126,11 @@ private:
     bool send(socket& dealer, const subscription& routing,
         const std::string& command, const system::code& status, size_t height,
         const system::hash_digest& tx_hash);
+    bool send(socket& dealer, const subscription& routing,
+        const std::string& command, const system::code& status, size_t height,
+        const system::hash_digest& tx_hash,
+        const system::hash_digest& key_status);
+    bool send(socket& dealer, const message& reply);
 
     // These are thread safe.
     const bool secure_;
@@ -19,10 +19,11 @@
 #ifndef LIBBITCOIN_SERVER_QUERY_WORKER_HPP
 #define LIBBITCOIN_SERVER_QUERY_WORKER_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <functional>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include <bitcoin/protocol.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/messages/message.hpp>
@@ -48,11 +49,44 @@ public:
 protected:
     typedef bc::protocol::zmq::socket socket;
 
-    typedef std::function<void(const message&, send_handler)> command_handler;
-    typedef std::unordered_map<std::string, command_handler> command_map;
+    typedef void(*command_handler)(server_node&, const message&,
+        send_handler);
+
+    /// A command, its handler and the inclusive bounds of its request size.
+    /// Requests within the bounds are validated exactly by the handler.
+    struct command
+    {
+        const char* name;
+        size_t length;
+        uint32_t hash;
+        command_handler handler;
+        size_t minimum;
+        size_t maximum;
+    };
+
+    /// Open addressed by command hash, empty slots have no handler.
+    typedef std::vector<command> command_table;
+
+    /// FNV-1a hash of the command text, usable at compile time.
+    static constexpr uint32_t hash(const char* text,
+        uint32_t basis=2166136261u)
+    {
+        return *text == '\0' ? basis : hash(text + 1,
+            (basis ^ static_cast<uint8_t>(*text)) * 16777619u);
+    }
 
     virtual void attach_interface();
-    virtual void attach(const std::string& command, command_handler handler);
+    virtual void attach(const command& value);
+
+    /// Size the table to the attached commands and index them.
+    void index();
+
+    /// The command matching the name of length characters, or nullptr.
+    const command* find(const uint8_t* name, size_t length) const;
+
+    /// Locate the command of the received command frame and bound its size.
+    system::code validate(const system::data_chunk& frame, size_t size,
+        const command*& entry) const;
 
     virtual bool connect(socket& dealer);
     virtual bool disconnect(socket& dealer);
@@ -62,6 +96,10 @@ protected:
     virtual void work();
 
 private:
+    static bool is_deflated(const std::string& command);
+    static bool is_deflated(const system::data_chunk& frame);
+    static void respond(const message& response,
+        bc::protocol::zmq::socket& dealer, uint32_t threshold);
     static void send(const message& response,
         bc::protocol::zmq::socket& dealer);
 
@@ -75,8 +113,9 @@ private:
     bc::protocol::zmq::authenticator& authenticator_;
     server_node& node_;
 
-    // This is protected by worker base class mutex.
-    command_map command_handlers_;
+    // These are protected by worker base class mutex.
+    command_table attached_;
+    command_table commands_;
 };
 
 } // namespace server
@@ -0,0 +1,537 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/caches/balance_cache.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <bitcoin/blockchain.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/utility/payment_key.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+using namespace bc::system::chain;
+
+// Reorganizations deeper than this clear the cache.
+static constexpr size_t journal_depth = 100;
+
+// The number of pool transaction keys tracked to validate history reads.
+static constexpr size_t announcement_limit = 65536;
+
+// Blocks after which the keys of a pool transaction are evicted and reread.
+static constexpr size_t unconfirmed_block_limit = 6;
+
+// The xor of entry digests is independent of order and self-inverting, so a
+// status is updated by toggling the entries that are added or removed.
+void balance_cache::toggle(hash_digest& status, const hash_digest& tx_hash,
+    size_t height)
+{
+    const auto digest = sha256_hash(build_chunk(
+    {
+        tx_hash,
+        to_little_endian(safe_unsigned<uint32_t>(height))
+    }));
+
+    std::transform(status.begin(), status.end(), digest.begin(),
+        status.begin(), std::bit_xor<uint8_t>());
+}
+
+// Spend records carry the checksum of the spent point in place of a value.
+balance_cache::balance balance_cache::compute(
+    const payment_record::list& payments, pool_deltas& pool,
+    point_values& unspent)
+{
+    balance result{ 0, 0, 0, max_uint32, max_uint32, null_hash };
+    point_values values;
+    std::unordered_set<hash_digest> confirmed;
+    std::set<std::pair<hash_digest, size_t>> entries;
+
+    // A transaction is commonly referenced by both output and spend records.
+    for (const auto& record: payments)
+        if (entries.emplace(record.hash(), record.height()).second)
+            toggle(result.status, record.hash(), record.height());
+
+    for (const auto& record: payments)
+        if (record.is_output())
+            values[output_point{ record.hash(), record.index() }.checksum()] =
+                record.data();
+
+    unspent = values;
+
+    for (const auto& record: payments)
+    {
+        // Unconfirmed records have a height of max_uint32.
+        const auto pooled = record.height() == max_uint32;
+
+        if (!record.is_output())
+        {
+            if (pooled)
+                pool[record.hash()].spends.push_back(record.data());
+            else
+                unspent.erase(record.data());
+        }
+
+        const auto value = values.find(record.data());
+
+        if (!record.is_output() && value == values.end())
+            continue;
+
+        const auto delta = record.is_output() ?
+            static_cast<int64_t>(record.data()) :
+            -static_cast<int64_t>(value->second);
+
+        if (pooled)
+        {
+            pool[record.hash()].value += delta;
+            result.unconfirmed += delta;
+            continue;
+        }
+
+        result.confirmed += static_cast<uint64_t>(delta);
+
+        if (confirmed.insert(record.hash()).second)
+            ++result.transactions;
+
+        result.first_height = std::min(result.first_height, record.height());
+        result.last_height = result.last_height == max_uint32 ?
+            record.height() : std::max(result.last_height, record.height());
+    }
+
+    return result;
+}
+
+balance_cache::balance_cache(size_t limit)
+  : limit_(limit),
+    top_(0),
+    sequence_(0),
+    reorganized_(0),
+    blocks_(0),
+    announced_(announcement_limit)
+{
+}
+
+// Called once at startup, prior to reorganization subscription handling.
+bool balance_cache::initialize(const bc::blockchain::fast_chain& chain)
+{
+    size_t top;
+    if (!chain.get_top_height(top, false))
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    top_ = top;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t balance_cache::sequence() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return sequence_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool balance_cache::get(balance& out, const hash_digest& key) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = balances_.find(key);
+
+    if (it == balances_.end())
+        return false;
+
+    out = it->second.value;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// A pool transaction of the key announced after the history was read may or
+// may not be included in the history, so the balance is not cached.
+bool balance_cache::put(const hash_digest& key, const balance& value,
+    const pool_deltas& pool, const point_values& unspent, size_t sequence)
+{
+    if (limit_ == 0)
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // A block was organized or the key was announced since the read.
+    if (reorganized_ > sequence || announced_.changed(key, sequence))
+        return false;
+
+    if (balances_.find(key) != balances_.end())
+        return true;
+
+    evict();
+    auto& entry = balances_[key];
+    entry.value = value;
+    entry.height = top_;
+    order_.push_back(key);
+
+    for (const auto& output: unspent)
+    {
+        outputs_[output.first] = owned_output{ key, output.second };
+        entry.points.push_back(output.first);
+    }
+
+    for (const auto& delta: pool)
+    {
+        auto& pooled = pool_[delta.first];
+
+        if (pooled.deltas.empty())
+            pooled.blocks = blocks_;
+
+        pooled.deltas[key] = delta.second.value;
+        pooled.spends.insert(pooled.spends.end(), delta.second.spends.begin(),
+            delta.second.spends.end());
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void balance_cache::reorganize(size_t fork_height,
+    const block_const_ptr_list& incoming)
+{
+    if (limit_ == 0)
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    reorganized_ = ++sequence_;
+
+    if (fork_height < top_ && !rollback(fork_height))
+        clear();
+
+    top_ = fork_height;
+    std::unordered_set<uint64_t> spent;
+
+    for (const auto& block: incoming)
+        apply(++top_, *block, spent);
+
+    blocks_ += incoming.size();
+    expire(spent);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void balance_cache::notify(const transaction& tx)
+{
+    if (limit_ == 0)
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto hash = tx.hash();
+    announced_.record(tx, ++sequence_);
+
+    if (pool_.find(hash) != pool_.end())
+        return;
+
+    auto deltas = to_deltas(tx);
+
+    // Outputs are retained so that chained pool spends are valued.
+    add_outputs(tx, hash);
+
+    if (deltas.empty())
+        return;
+
+    for (const auto& delta: deltas)
+    {
+        auto& value = balances_[delta.first].value;
+        value.unconfirmed += delta.second;
+        toggle(value.status, hash, max_uint32);
+    }
+
+    std::vector<uint64_t> spends;
+
+    for (const auto& input: tx.inputs())
+        spends.push_back(input.previous_output().checksum());
+
+    pool_.emplace(hash, pooled{ std::move(deltas), std::move(spends),
+        blocks_ });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private, call under lock.
+// Inputs are valued from the retained outputs of cached keys.
+balance_cache::key_deltas balance_cache::to_deltas(
+    const transaction& tx) const
+{
+    key_deltas out;
+
+    for (const auto& output: tx.outputs())
+    {
+        const auto key = payment_key::to_key(output.script());
+
+        if (balances_.find(key) != balances_.end())
+            out[key] += static_cast<int64_t>(output.value());
+    }
+
+    if (tx.is_coinbase())
+        return out;
+
+    for (const auto& input: tx.inputs())
+    {
+        const auto it = outputs_.find(input.previous_output().checksum());
+
+        if (it != outputs_.end())
+            out[it->second.key] -= static_cast<int64_t>(it->second.value);
+    }
+
+    return out;
+}
+
+// private, call under unique lock.
+void balance_cache::add_outputs(const transaction& tx, const hash_digest& hash)
+{
+    const auto& outputs = tx.outputs();
+
+    for (uint32_t index = 0; index < outputs.size(); ++index)
+    {
+        const auto key = payment_key::to_key(outputs[index].script());
+        const auto it = balances_.find(key);
+
+        if (it == balances_.end())
+            continue;
+
+        const auto checksum = output_point{ hash, index }.checksum();
+        outputs_[checksum] = owned_output{ key, outputs[index].value() };
+        it->second.points.push_back(checksum);
+    }
+}
+
+// private, call under unique lock.
+// Confirmed spends release the spent outputs (journaled for rollback).
+void balance_cache::apply(size_t height, const block& block,
+    std::unordered_set<uint64_t>& spent)
+{
+    const auto height32 = safe_unsigned<uint32_t>(height);
+    journal_entry entry{ height, {}, {}, {} };
+
+    for (const auto& tx: block.transactions())
+    {
+        const auto hash = tx.hash();
+
+        for (const auto& delta: to_deltas(tx))
+        {
+            auto& value = balances_[delta.first].value;
+            entry.previous.emplace(delta.first, value);
+            value.confirmed += static_cast<uint64_t>(delta.second);
+            value.first_height = std::min(value.first_height, height32);
+            value.last_height = height32;
+            toggle(value.status, hash, height);
+            ++value.transactions;
+        }
+
+        add_outputs(tx, hash);
+
+        if (!tx.is_coinbase())
+        {
+            for (const auto& input: tx.inputs())
+            {
+                const auto checksum = input.previous_output().checksum();
+                const auto it = outputs_.find(checksum);
+                spent.insert(checksum);
+
+                if (it == outputs_.end())
+                    continue;
+
+                entry.spent.insert(*it);
+                outputs_.erase(it);
+            }
+        }
+
+        // A confirmed transaction no longer counts as unconfirmed.
+        const auto pooled = pool_.find(hash);
+
+        if (pooled == pool_.end())
+            continue;
+
+        for (const auto& delta: pooled->second.deltas)
+        {
+            const auto it = balances_.find(delta.first);
+
+            if (it == balances_.end())
+                continue;
+
+            entry.previous.emplace(delta.first, it->second.value);
+            it->second.value.unconfirmed -= delta.second;
+            toggle(it->second.value.status, hash, max_uint32);
+        }
+
+        entry.confirmed.insert(*pooled);
+        pool_.erase(pooled);
+    }
+
+    journal_.push_back(std::move(entry));
+
+    if (journal_.size() > journal_depth)
+        journal_.pop_front();
+}
+
+// private, call under unique lock.
+// A pool transaction that spends a point spent by the incoming blocks has
+// been dropped by the pool, as will have been its descendants (which are
+// expired by age). The affected keys are evicted so that they are reread.
+void balance_cache::expire(const std::unordered_set<uint64_t>& spent)
+{
+    std::unordered_set<hash_digest> keys;
+
+    for (auto it = pool_.begin(); it != pool_.end();)
+    {
+        const auto& value = it->second;
+        const auto expired = blocks_ - value.blocks > unconfirmed_block_limit;
+        const auto conflicted = std::any_of(value.spends.begin(),
+            value.spends.end(), [&spent](uint64_t checksum)
+            {
+                return spent.find(checksum) != spent.end();
+            });
+
+        if (!expired && !conflicted)
+        {
+            ++it;
+            continue;
+        }
+
+        for (const auto& delta: value.deltas)
+            keys.insert(delta.first);
+
+        it = pool_.erase(it);
+    }
+
+    for (const auto& key: keys)
+        remove(key);
+}
+
+// private, call under unique lock.
+// Restores the balances, outputs and pool entries changed by each block above
+// the fork point. A key populated above the fork point is evicted.
+bool balance_cache::rollback(size_t fork_height)
+{
+    if (journal_.empty() || journal_.front().height > fork_height + 1)
+        return false;
+
+    while (!journal_.empty() && journal_.back().height > fork_height)
+    {
+        const auto& entry = journal_.back();
+
+        for (const auto& previous: entry.previous)
+        {
+            const auto it = balances_.find(previous.first);
+
+            if (it != balances_.end())
+                it->second.value = previous.second;
+        }
+
+        for (const auto& output: entry.spent)
+            if (balances_.find(output.second.key) != balances_.end())
+                outputs_.insert(output);
+
+        for (const auto& pooled: entry.confirmed)
+            pool_.insert(pooled);
+
+        journal_.pop_back();
+    }
+
+    std::vector<hash_digest> populated;
+
+    for (const auto& entry: balances_)
+        if (entry.second.height > fork_height)
+            populated.push_back(entry.first);
+
+    for (const auto& key: populated)
+        remove(key);
+
+    return true;
+}
+
+// private, call under unique lock.
+// Removes the key with its retained outputs and its pool deltas.
+void balance_cache::remove(const hash_digest& key)
+{
+    const auto it = balances_.find(key);
+
+    if (it == balances_.end())
+        return;
+
+    for (const auto checksum: it->second.points)
+    {
+        const auto output = outputs_.find(checksum);
+
+        if (output != outputs_.end() && output->second.key == key)
+            outputs_.erase(output);
+    }
+
+    balances_.erase(it);
+
+    for (auto pooled = pool_.begin(); pooled != pool_.end();)
+    {
+        pooled->second.deltas.erase(key);
+        pooled = pooled->second.deltas.empty() ? pool_.erase(pooled) :
+            std::next(pooled);
+    }
+}
+
+// private, call under unique lock.
+// Keys are evicted in population order, skipping those already removed.
+void balance_cache::evict()
+{
+    while (balances_.size() >= limit_ && !order_.empty())
+    {
+        const auto key = order_.front();
+        order_.pop_front();
+        remove(key);
+    }
+}
+
+// private, call under unique lock.
+void balance_cache::clear()
+{
+    balances_.clear();
+    outputs_.clear();
+    order_.clear();
+    journal_.clear();
+    pool_.clear();
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/caches/filter_cache.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+
+static constexpr auto canonical = system::message::version::level::canonical;
+
+const uint8_t filter_cache::filter_type = 0;
+
+filter_cache::filter_cache(size_t limit)
+  : limit_(limit), generation_(0), first_(0)
+{
+}
+
+// Called at startup (with fork at top) and upon each reorganization.
+size_t filter_cache::reorganize(size_t& start, size_t fork_height,
+    size_t top_height)
+{
+    const auto floor = top_height < limit_ ? 0 : top_height - limit_ + 1;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    while (!window_.empty() && first_ + window_.size() - 1 > fork_height)
+    {
+        heights_.erase(window_.back().block_hash);
+        window_.pop_back();
+    }
+
+    // A window that cannot be extended contiguously is restarted at floor.
+    if (first_ + window_.size() < floor)
+    {
+        window_.clear();
+        heights_.clear();
+    }
+
+    if (window_.empty())
+        first_ = floor;
+
+    start = first_ + window_.size();
+    return ++generation_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool filter_cache::push(size_t generation, size_t height,
+    const hash_digest& header, const compact_filter& filter)
+{
+    auto data = filter.to_data(canonical);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (limit_ == 0 || generation != generation_ ||
+        height != first_ + window_.size())
+        return false;
+
+    heights_[filter.block_hash()] = height;
+    window_.push_back({ filter.block_hash(), header, std::move(data) });
+
+    while (window_.size() > limit_)
+    {
+        heights_.erase(window_.front().block_hash);
+        window_.pop_front();
+        ++first_;
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool filter_cache::get(data_chunk& out, size_t& count, size_t start,
+    const hash_digest& stop_hash, size_t maximum) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = heights_.find(stop_hash);
+
+    if (it == heights_.end() || start < first_ || start > it->second)
+        return false;
+
+    count = std::min(it->second - start + 1, maximum);
+    const auto begin = window_.begin() + (start - first_);
+    const auto end = begin + count;
+
+    for (auto entry = begin; entry != end; ++entry)
+    {
+        out.insert(out.end(), entry->header.begin(), entry->header.end());
+        out.insert(out.end(), entry->filter.begin(), entry->filter.end());
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Entries are serialized as [type:1][block_hash:32][size:varint][filter].
+bool filter_cache::get_filter(hash_digest& block_hash, data_chunk& out,
+    size_t height) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    if (height < first_ || height - first_ >= window_.size())
+        return false;
+
+    const auto& filter = window_[height - first_].filter;
+    auto deserial = make_safe_deserializer(filter.begin(), filter.end());
+    deserial.skip(sizeof(uint8_t));
+    block_hash = deserial.read_hash();
+    out = deserial.read_bytes(deserial.read_variable_little_endian());
+    return bool(deserial);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t filter_cache::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return window_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace server
+} // namespace libbitcoin
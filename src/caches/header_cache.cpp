@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/caches/header_cache.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+using namespace bc::system::chain;
+
+static constexpr auto canonical = system::message::version::level::canonical;
+
+const size_t header_cache::header_size = chain::header::satoshi_fixed_size();
+
+header_cache::header_cache()
+{
+}
+
+// A stale read links to the cached top only if the reorganization that
+// superseded it has not yet been applied, in which case it is then popped.
+bool header_cache::push(size_t height, const chain::header& header)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto cached = headers_.size() / header_size;
+
+    if (height != cached)
+        return false;
+
+    if (height != 0)
+    {
+        const auto top = headers_.end() - header_size;
+        const auto hash = bitcoin_hash(data_slice(&*top,
+            &*top + header_size));
+
+        if (header.previous_block_hash() != hash)
+            return false;
+    }
+
+    append(header);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_cache::pop(size_t height)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (height + 1 != headers_.size() / header_size)
+        return false;
+
+    const auto top = headers_.end() - header_size;
+    heights_.erase(bitcoin_hash(data_slice(&*top, &*top + header_size)));
+    headers_.resize(headers_.size() - header_size);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_cache::reorganize(size_t fork_height,
+    const block_const_ptr_list& incoming)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (fork_height >= headers_.size() / header_size)
+        return false;
+
+    pop_above(fork_height);
+
+    for (const auto& block: incoming)
+        append(block->header());
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t header_cache::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return headers_.size() / header_size;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_cache::get_header(data_chunk& out, size_t height) const
+{
+    return get_headers(out, height, 1) == 1;
+}
+
+size_t header_cache::get_headers(data_chunk& out, size_t start,
+    size_t count) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto cached = headers_.size() / header_size;
+
+    if (start >= cached)
+        return 0;
+
+    const auto result = std::min(count, cached - start);
+    const auto begin = headers_.begin() + start * header_size;
+    out.insert(out.end(), begin, begin + result * header_size);
+    return result;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool header_cache::get_height(size_t& out, const hash_digest& hash) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = heights_.find(hash);
+
+    if (it == heights_.end())
+        return false;
+
+    out = it->second;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private, call under unique lock.
+void header_cache::append(const chain::header& header)
+{
+    const auto height = headers_.size() / header_size;
+    const auto data = header.to_data(canonical);
+    headers_.insert(headers_.end(), data.begin(), data.end());
+    heights_[header.hash()] = height;
+}
+
+// private, call under unique lock.
+void header_cache::pop_above(size_t height)
+{
+    const auto end = (height + 1) * header_size;
+
+    for (auto offset = end; offset < headers_.size(); offset += header_size)
+    {
+        const auto begin = headers_.begin() + offset;
+        heights_.erase(bitcoin_hash(data_slice(&*begin,
+            &*begin + header_size)));
+    }
+
+    headers_.resize(end);
+}
+
+} // namespace server
+} // namespace libbitcoin
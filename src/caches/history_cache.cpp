@@ -0,0 +1,527 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/caches/history_cache.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/utility/payment_key.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+using namespace bc::system::chain;
+
+// The sketch rows are indexed by distinct 16 bit slices of the key (a hash).
+static constexpr size_t sketch_rows = 4;
+static constexpr size_t sketch_width = 1u << 16;
+static constexpr uint8_t counter_limit = 15;
+
+// Counters are halved after this many samples, so that estimates age.
+static constexpr size_t sample_limit = 10 * sketch_width;
+
+// Approximate bytes of an entry in addition to its records.
+static constexpr size_t entry_overhead = 256;
+
+// Approximate bytes of the point index of a record (an output).
+static constexpr size_t index_overhead = 64;
+
+// The number of pool transaction keys tracked to validate history reads.
+static constexpr size_t announcement_limit = 65536;
+
+// Blocks after which a key with an unconfirmed record is evicted and reread.
+static constexpr size_t unconfirmed_block_limit = 6;
+
+static size_t sketch_index(const hash_digest& key, size_t row)
+{
+    const size_t slice = (key[2 * row] << 8) | key[2 * row + 1];
+    return row * sketch_width + slice;
+}
+
+static payment_record to_record(const hash_digest& hash, uint32_t index,
+    size_t height, uint64_t data, bool output)
+{
+    payment_record record(height, index, data, output);
+    record.set_hash(hash_digest(hash));
+    return record;
+}
+
+history_cache::history_cache(size_t budget)
+  : budget_(budget),
+    hits_(0),
+    misses_(0),
+    admissions_(0),
+    rejections_(0),
+    samples_(0),
+    sketch_(budget == 0 ? 0 : sketch_rows * sketch_width),
+    sequence_(0),
+    reorganized_(0),
+    blocks_(0),
+    size_(0),
+    announced_(announcement_limit)
+{
+}
+
+size_t history_cache::hits() const
+{
+    return hits_;
+}
+
+size_t history_cache::misses() const
+{
+    return misses_;
+}
+
+size_t history_cache::admissions() const
+{
+    return admissions_;
+}
+
+size_t history_cache::rejections() const
+{
+    return rejections_;
+}
+
+size_t history_cache::sequence() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return sequence_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool history_cache::get(payment_record::list& out, const hash_digest& key,
+    size_t from_height)
+{
+    if (budget_ == 0)
+    {
+        ++misses_;
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    increment(key);
+    const auto it = entries_.find(key);
+
+    if (it == entries_.end())
+    {
+        ++misses_;
+        return false;
+    }
+
+    it->second.referenced = true;
+
+    // Unconfirmed records have a height of max_uint32.
+    for (const auto& record: it->second.records)
+        if (record.height() >= from_height)
+            out.push_back(record);
+
+    ++hits_;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool history_cache::admissible(const hash_digest& key) const
+{
+    if (budget_ == 0)
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return size_ < budget_ || recency_.empty() ||
+        frequency(key) > frequency(recency_.back());
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// A pool transaction of the key announced after the history was read may or
+// may not be included in the history, so the history is not admitted. If more
+// pool keys have been announced than are tracked this cannot be determined.
+bool history_cache::put(const hash_digest& key,
+    const payment_record::list& records, size_t sequence)
+{
+    if (budget_ == 0)
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // A block was organized or the key was announced since the read.
+    if (reorganized_ > sequence || announced_.changed(key, sequence))
+        return false;
+
+    if (entries_.find(key) != entries_.end())
+        return true;
+
+    const auto required = cost(records.size());
+
+    if (!admit(key, required))
+    {
+        ++rejections_;
+        return false;
+    }
+
+    recency_.push_front(key);
+    auto& value = entries_[key];
+    value.records = records;
+    value.position = recency_.begin();
+    value.referenced = false;
+    add_outputs(key, records);
+
+    for (const auto& record: records)
+        if (record.height() == max_uint32)
+            value.unconfirmed.emplace(record.hash(), blocks_);
+
+    size_ += required;
+    ++admissions_;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void history_cache::reorganize(size_t fork_height,
+    const block_const_ptr_list& incoming)
+{
+    if (budget_ == 0)
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    reorganized_ = ++sequence_;
+
+    // Records above the fork point have been reorganized out (and their
+    // transactions may or may not have been returned to the pool).
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+        const auto& records = it->second.records;
+        const auto affected = std::any_of(records.begin(), records.end(),
+            [fork_height](const payment_record& record)
+            {
+                return record.height() != max_uint32 &&
+                    record.height() > fork_height;
+            });
+
+        if (affected)
+            evict(it++);
+        else
+            ++it;
+    }
+
+    auto height = fork_height;
+
+    for (const auto& block: incoming)
+    {
+        ++height;
+
+        for (const auto& tx: block->transactions())
+            append(height, tx);
+    }
+
+    blocks_ += incoming.size();
+    expire(incoming);
+    shrink();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void history_cache::notify(const transaction& tx)
+{
+    if (budget_ == 0)
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    announced_.record(tx, ++sequence_);
+    append(max_uint32, tx);
+    shrink();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// ----------------------------------------------------------------------------
+
+size_t history_cache::cost(size_t records)
+{
+    return entry_overhead + records * (sizeof(payment_record) +
+        index_overhead);
+}
+
+// Call under any lock, the counters are atomic.
+// Concurrent increments may be lost, which is tolerable in an estimate.
+void history_cache::increment(const hash_digest& key)
+{
+    for (size_t row = 0; row < sketch_rows; ++row)
+    {
+        auto& counter = sketch_[sketch_index(key, row)];
+        auto value = counter.load(std::memory_order_relaxed);
+
+        while (value < counter_limit && !counter.compare_exchange_weak(value,
+            static_cast<uint8_t>(value + 1), std::memory_order_relaxed));
+    }
+
+    // Only the query that reaches the limit ages the counters.
+    if (++samples_ != sample_limit)
+        return;
+
+    samples_ = 0;
+
+    for (auto& counter: sketch_)
+        counter.store(counter.load(std::memory_order_relaxed) >> 1,
+            std::memory_order_relaxed);
+}
+
+// Call under any lock.
+size_t history_cache::frequency(const hash_digest& key) const
+{
+    uint8_t minimum = counter_limit;
+
+    for (size_t row = 0; row < sketch_rows; ++row)
+        minimum = std::min(minimum, sketch_[sketch_index(key, row)].load(
+            std::memory_order_relaxed));
+
+    return minimum;
+}
+
+// Call under unique lock.
+// The output records of the key are indexed by point checksum.
+void history_cache::add_outputs(const hash_digest& key,
+    const payment_record::list& records)
+{
+    for (const auto& record: records)
+        if (record.is_output())
+            outputs_[output_point{ record.hash(), record.index() }.checksum()] =
+                key;
+}
+
+// Call under unique lock.
+// Spend records carry the checksum of the spent point in place of a value.
+// Inputs are attributed by the indexed outputs of cached keys, an input that
+// spends no indexed output does not spend from a cached key.
+void history_cache::append(size_t height, const transaction& tx)
+{
+    if (entries_.empty())
+        return;
+
+    const auto hash = tx.hash();
+    std::unordered_map<hash_digest, payment_record::list> additions;
+    const auto& outputs = tx.outputs();
+
+    for (uint32_t index = 0; index < outputs.size(); ++index)
+    {
+        const auto key = payment_key::to_key(outputs[index].script());
+
+        if (entries_.find(key) == entries_.end())
+            continue;
+
+        // Indexed before the inputs of later transactions are attributed.
+        outputs_[output_point{ hash, index }.checksum()] = key;
+        additions[key].push_back(to_record(hash, index, height,
+            outputs[index].value(), true));
+    }
+
+    if (!tx.is_coinbase())
+    {
+        const auto& inputs = tx.inputs();
+
+        for (uint32_t index = 0; index < inputs.size(); ++index)
+        {
+            const auto checksum = inputs[index].previous_output().checksum();
+            const auto it = outputs_.find(checksum);
+
+            if (it != outputs_.end())
+                additions[it->second].push_back(to_record(hash, index,
+                    height, checksum, false));
+        }
+    }
+
+    for (auto& addition: additions)
+    {
+        auto& value = entries_[addition.first];
+        auto& records = value.records;
+        const auto before = cost(records.size());
+
+        if (height == max_uint32)
+        {
+            if (!value.unconfirmed.emplace(hash, blocks_).second)
+                continue;
+        }
+        else if (value.unconfirmed.erase(hash) != 0)
+        {
+            // The confirmed records replace the unconfirmed.
+            records.erase(std::remove_if(records.begin(), records.end(),
+                [&hash](const payment_record& record)
+                {
+                    return record.height() == max_uint32 &&
+                        record.hash() == hash;
+                }), records.end());
+        }
+
+        records.insert(records.end(),
+            std::make_move_iterator(addition.second.begin()),
+            std::make_move_iterator(addition.second.end()));
+
+        size_ = size_ - before + cost(records.size());
+    }
+}
+
+// Call under unique lock.
+// Unconfirmed records are not removed when the pool drops a transaction, so a
+// key is evicted if it has an unconfirmed spend of a point spent by the
+// incoming blocks (a conflict) or an unconfirmed record that has outlived the
+// block limit (which includes descendants of conflicts).
+void history_cache::expire(const block_const_ptr_list& incoming)
+{
+    if (entries_.empty())
+        return;
+
+    std::unordered_set<uint64_t> spent;
+
+    for (const auto& block: incoming)
+        for (const auto& tx: block->transactions())
+            if (!tx.is_coinbase())
+                for (const auto& input: tx.inputs())
+                    spent.insert(input.previous_output().checksum());
+
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+        const auto& value = it->second;
+        const auto expired = std::any_of(value.unconfirmed.begin(),
+            value.unconfirmed.end(),
+            [this](const sequence_map::value_type& unconfirmed)
+            {
+                return blocks_ - unconfirmed.second > unconfirmed_block_limit;
+            });
+
+        const auto conflicted = !value.unconfirmed.empty() && std::any_of(
+            value.records.begin(), value.records.end(),
+            [&spent](const payment_record& record)
+            {
+                return record.height() == max_uint32 && !record.is_output() &&
+                    spent.find(record.data()) != spent.end();
+            });
+
+        if (expired || conflicted)
+            evict(it++);
+        else
+            ++it;
+    }
+}
+
+// Call under unique lock.
+// Keys referenced since the last promotion are moved to the front of the
+// recency list (in their relative order), so the back is the least recent.
+void history_cache::promote()
+{
+    lru_list referenced;
+
+    for (auto it = recency_.begin(); it != recency_.end();)
+    {
+        const auto current = it++;
+
+        if (entries_.find(*current)->second.referenced.exchange(false))
+            referenced.splice(referenced.end(), recency_, current);
+    }
+
+    recency_.splice(recency_.begin(), referenced);
+}
+
+// Call under unique lock.
+void history_cache::shrink()
+{
+    if (size_ <= budget_)
+        return;
+
+    promote();
+
+    while (size_ > budget_ && !recency_.empty())
+        evict(entries_.find(recency_.back()));
+}
+
+// Call under unique lock.
+// Victims are taken in recency order and must be less frequently queried.
+bool history_cache::admit(const hash_digest& key, size_t required)
+{
+    if (required > budget_)
+        return false;
+
+    promote();
+
+    const auto candidate = frequency(key);
+    std::vector<entry_map::iterator> victims;
+    auto available = budget_ - std::min(size_, budget_);
+
+    for (auto it = recency_.rbegin();
+        available < required && it != recency_.rend(); ++it)
+    {
+        if (frequency(*it) >= candidate)
+            return false;
+
+        const auto victim = entries_.find(*it);
+        available += cost(victim->second.records.size());
+        victims.push_back(victim);
+    }
+
+    if (available < required)
+        return false;
+
+    for (const auto victim: victims)
+        evict(victim);
+
+    return true;
+}
+
+// Call under unique lock.
+void history_cache::evict(entry_map::iterator it)
+{
+    for (const auto& record: it->second.records)
+    {
+        if (!record.is_output())
+            continue;
+
+        const auto output = outputs_.find(
+            output_point{ record.hash(), record.index() }.checksum());
+
+        if (output != outputs_.end() && output->second == it->first)
+            outputs_.erase(output);
+    }
+
+    size_ -= cost(it->second.records.size());
+    recency_.erase(it->second.position);
+    entries_.erase(it);
+}
+
+} // namespace server
+} // namespace libbitcoin
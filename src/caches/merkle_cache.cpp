@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/caches/merkle_cache.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+
+// static
+// An odd hash at any level is paired with itself.
+merkle_cache::level_list merkle_cache::to_levels(const hash_list& hashes)
+{
+    level_list levels;
+
+    if (hashes.empty())
+        return levels;
+
+    levels.push_back(hashes);
+
+    while (levels.back().size() > 1u)
+    {
+        const auto& level = levels.back();
+        hash_list parents;
+        parents.reserve((level.size() + 1u) / 2u);
+
+        for (size_t index = 0; index < level.size(); index += 2u)
+        {
+            const auto& left = level[index];
+            const auto& right = index + 1u < level.size() ? level[index + 1u] :
+                left;
+
+            parents.push_back(bitcoin_hash(build_chunk({ left, right })));
+        }
+
+        levels.push_back(std::move(parents));
+    }
+
+    return levels;
+}
+
+// static
+hash_list merkle_cache::to_branch(const level_list& levels, size_t position)
+{
+    hash_list branch;
+
+    if (levels.empty())
+        return branch;
+
+    branch.reserve(levels.size() - 1u);
+
+    for (size_t depth = 0; depth + 1u < levels.size(); ++depth)
+    {
+        const auto& level = levels[depth];
+        const auto sibling = position ^ 1u;
+        branch.push_back(sibling < level.size() ? level[sibling] :
+            level[position]);
+        position >>= 1;
+    }
+
+    return branch;
+}
+
+merkle_cache::merkle_cache(size_t limit)
+  : limit_(limit), sequence_(0)
+{
+}
+
+size_t merkle_cache::sequence() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return sequence_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool merkle_cache::get_branch(hash_list& out, size_t height, size_t position)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto it = entries_.find(height);
+
+    if (it == entries_.end() || it->second.levels.empty() ||
+        position >= it->second.levels.front().size())
+        return false;
+
+    recency_.splice(recency_.begin(), recency_, it->second.position);
+    out = to_branch(it->second.levels, position);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool merkle_cache::put(size_t height, const level_list& levels,
+    size_t sequence)
+{
+    if (limit_ == 0)
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // The tree may have been read from a chain since reorganized.
+    if (sequence != sequence_)
+        return false;
+
+    insert(height, levels);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Trees are computed from the incoming blocks before the lock is taken.
+void merkle_cache::reorganize(size_t fork_height,
+    const block_const_ptr_list& incoming)
+{
+    if (limit_ == 0)
+        return;
+
+    std::vector<level_list> trees;
+    trees.reserve(incoming.size());
+
+    for (const auto& block: incoming)
+    {
+        hash_list hashes;
+        hashes.reserve(block->transactions().size());
+
+        for (const auto& tx: block->transactions())
+            hashes.push_back(tx.hash());
+
+        trees.push_back(to_levels(hashes));
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    ++sequence_;
+
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+        if (it->first > fork_height)
+        {
+            recency_.erase(it->second.position);
+            it = entries_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    auto height = fork_height;
+
+    for (const auto& levels: trees)
+        insert(++height, levels);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private, call under unique lock.
+void merkle_cache::insert(size_t height, const level_list& levels)
+{
+    const auto it = entries_.find(height);
+
+    if (it != entries_.end())
+    {
+        it->second.levels = levels;
+        recency_.splice(recency_.begin(), recency_, it->second.position);
+        return;
+    }
+
+    recency_.push_front(height);
+    entries_.emplace(height, entry{ levels, recency_.begin() });
+
+    while (entries_.size() > limit_)
+    {
+        entries_.erase(recency_.back());
+        recency_.pop_back();
+    }
+}
+
+} // namespace server
+} // namespace libbitcoin
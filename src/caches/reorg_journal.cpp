@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/caches/reorg_journal.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <bitcoin/blockchain.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/utility/payment_key.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+using namespace bc::system::chain;
+
+reorg_journal::reorg_journal(size_t depth)
+  : depth_(depth), top_(0)
+{
+}
+
+// Called once at startup, prior to reorganization subscription handling.
+bool reorg_journal::initialize(const bc::blockchain::fast_chain& chain)
+{
+    size_t top;
+    if (!chain.get_top_height(top, false))
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    top_ = top;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Spends are keyed by the previous output cached by validation, which blocks
+// read from the store generally do not carry, or else by an output of an
+// earlier outgoing transaction.
+void reorg_journal::reorganize(size_t fork_height,
+    const block_const_ptr_list& incoming,
+    const block_const_ptr_list& outgoing)
+{
+    if (depth_ == 0)
+        return;
+
+    reorganization entry
+    {
+        fork_height, fork_height + outgoing.size(), true, {}
+    };
+
+    std::unordered_map<uint64_t, hash_digest> outputs;
+    auto height = fork_height;
+
+    for (const auto& block: outgoing)
+    {
+        ++height;
+
+        for (const auto& tx: block->transactions())
+        {
+            const auto hash = tx.hash();
+            const auto& tx_outputs = tx.outputs();
+            std::unordered_set<hash_digest> keys;
+
+            for (uint32_t index = 0; index < tx_outputs.size(); ++index)
+            {
+                const auto key = payment_key::to_key(
+                    tx_outputs[index].script());
+                outputs.emplace(output_point{ hash, index }.checksum(), key);
+                keys.insert(key);
+            }
+
+            if (!tx.is_coinbase())
+            {
+                for (const auto& input: tx.inputs())
+                {
+                    const auto& point = input.previous_output();
+                    const auto& prevout = point.metadata.cache;
+
+                    if (prevout.is_valid())
+                    {
+                        keys.insert(payment_key::to_key(prevout.script()));
+                        continue;
+                    }
+
+                    const auto it = outputs.find(point.checksum());
+
+                    if (it == outputs.end())
+                        entry.complete = false;
+                    else
+                        keys.insert(it->second);
+                }
+            }
+
+            for (const auto& key: keys)
+                entry.removals.emplace(key, removal{ hash, height });
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    top_ = fork_height + incoming.size();
+
+    if (!entry.removals.empty() || !entry.complete)
+        reorganizations_.push_back(std::move(entry));
+
+    // A sync point at or below the outgoing height may hold the removals, and
+    // is served while within depth of the top.
+    while (!reorganizations_.empty() &&
+        reorganizations_.front().outgoing_height + depth_ < top_)
+        reorganizations_.pop_front();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// A client that synchronized after a reorganization is also sent its
+// removals (which it does not hold) and the history above its fork point.
+// The removals of an incomplete reorganization are unknown, so the history
+// of a client that synchronized after it must be resent in full.
+bool reorg_journal::removed(removal_list& out, size_t& from,
+    const hash_digest& key, size_t sync_height) const
+{
+    if (depth_ == 0)
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    if (sync_height + depth_ < top_)
+        return false;
+
+    from = sync_height;
+
+    for (const auto& reorganization: reorganizations_)
+    {
+        if (reorganization.fork_height >= sync_height)
+            continue;
+
+        if (!reorganization.complete)
+            return false;
+
+        from = std::min(from, reorganization.fork_height);
+        const auto range = reorganization.removals.equal_range(key);
+
+        for (auto it = range.first; it != range.second; ++it)
+            if (it->second.height <= sync_height)
+                out.push_back(it->second);
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace server
+} // namespace libbitcoin
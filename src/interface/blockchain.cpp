@@ -18,15 +18,24 @@
  */
 #include <bitcoin/server/interface/blockchain.hpp>
 
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/configuration.hpp>
 #include <bitcoin/server/messages/message.hpp>
 #include <bitcoin/server/server_node.hpp>
+#include <bitcoin/server/utility/history_encoder.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -43,11 +52,754 @@ static constexpr size_t index_size = sizeof(uint32_t);
 static constexpr size_t point_size = hash_size + sizeof(uint32_t);
 static constexpr auto canonical = system::message::version::level::canonical;
 
+// Block range limits.
+static constexpr size_t maximum_range_credits = 500;
+static constexpr size_t range_read_ahead = 8;
+
+// This class is thread safe.
+// Reads a window of blocks with a bounded number of store reads outstanding
+// and sends each block, in height order, as soon as its predecessors are sent.
+class block_range
+  : public std::enable_shared_from_this<block_range>
+{
+public:
+    block_range(server_node& node, const message& request,
+        send_handler handler, size_t start, size_t stop)
+      : node_(node),
+        request_(request),
+        handler_(handler),
+        witness_(script::is_enabled(node.blockchain_settings().enabled_forks(),
+            rule_fork::bip141_rule)),
+        stop_(stop),
+        next_fetch_(start),
+        next_send_(start),
+        failed_(false)
+    {
+    }
+
+    void start()
+    {
+        fetch(next_heights());
+    }
+
+private:
+    typedef std::vector<size_t> heights;
+
+    // Call under lock (or before concurrency).
+    heights next_heights()
+    {
+        heights out;
+
+        while (next_fetch_ < stop_ &&
+            next_fetch_ - next_send_ < range_read_ahead)
+            out.push_back(next_fetch_++);
+
+        return out;
+    }
+
+    void fetch(const heights& values)
+    {
+        const auto self = shared_from_this();
+
+        for (const auto height: values)
+            node_.chain().fetch_block(height, witness_,
+                std::bind(&block_range::handle_fetched,
+                    self, _1, _2, height));
+    }
+
+    void handle_fetched(const code& ec, block_const_ptr block, size_t height)
+    {
+        heights values;
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+
+        if (failed_)
+        {
+            mutex_.unlock();
+            return;
+        }
+
+        if (ec)
+        {
+            failed_ = true;
+            mutex_.unlock();
+            handler_(message(request_, ec));
+            return;
+        }
+
+        ready_[height] = block;
+
+        // Sends are made under the lock to preserve height order.
+        for (auto it = ready_.find(next_send_); it != ready_.end();
+            it = ready_.find(next_send_))
+        {
+            // [ code:4 ]
+            // [ height:4 ]
+            // [ block... ]
+            handler_(message(request_, build_chunk(
+            {
+                message::to_bytes(error::success),
+                to_little_endian(static_cast<uint32_t>(next_send_)),
+                it->second->to_data(canonical)
+            })));
+
+            ready_.erase(it);
+            ++next_send_;
+        }
+
+        // [ code:4 ]
+        // [ next:4 ]
+        // The window is terminated by the height of the next window.
+        if (next_send_ == stop_)
+            handler_(message(request_, build_chunk(
+            {
+                message::to_bytes(error::success),
+                to_little_endian(static_cast<uint32_t>(stop_))
+            })));
+
+        values = next_heights();
+
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        fetch(values);
+    }
+
+    server_node& node_;
+    const message request_;
+    const send_handler handler_;
+    const bool witness_;
+    const size_t stop_;
+
+    // These are protected by mutex.
+    size_t next_fetch_;
+    size_t next_send_;
+    bool failed_;
+    std::map<size_t, block_const_ptr> ready_;
+    std::mutex mutex_;
+};
+
+// This class is thread safe.
+// Resolves the previous outputs of a transaction's inputs with one concurrent
+// store read per distinct previous transaction, confirmed or pooled, and
+// responds once all reads have completed (or upon the first failure). A
+// previous transaction that is not found leaves its outputs unresolved.
+class prevout_resolver
+  : public std::enable_shared_from_this<prevout_resolver>
+{
+public:
+    prevout_resolver(server_node& node, const message& request,
+        send_handler handler, transaction_const_ptr tx)
+      : node_(node),
+        request_(request),
+        handler_(handler),
+        tx_(tx),
+        pending_(0),
+        failed_(false)
+    {
+        for (const auto& input: tx->inputs())
+            if (!input.previous_output().is_null())
+                previous_[input.previous_output().hash()] = nullptr;
+    }
+
+    void start()
+    {
+        if (previous_.empty())
+        {
+            complete();
+            return;
+        }
+
+        const auto self = shared_from_this();
+        pending_ = previous_.size();
+
+        // Previous outputs are read without witness, the response excludes it.
+        const auto require_confirmed = false;
+        const auto witness = false;
+
+        for (const auto& entry: previous_)
+            node_.chain().fetch_transaction(entry.first, require_confirmed,
+                witness, std::bind(&prevout_resolver::handle_fetched,
+                    self, _1, _2, entry.first));
+    }
+
+private:
+    void handle_fetched(const code& ec, transaction_const_ptr tx,
+        const hash_digest& hash)
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+
+        if (failed_)
+        {
+            mutex_.unlock();
+            return;
+        }
+
+        if (ec && ec != error::not_found)
+        {
+            failed_ = true;
+            mutex_.unlock();
+            handler_(message(request_, ec));
+            return;
+        }
+
+        // The map is not resized after construction, only values are set.
+        if (!ec)
+            previous_[hash] = tx;
+
+        const auto completed = (--pending_ == 0);
+
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        if (completed)
+            complete();
+    }
+
+    // [ code:4 ]
+    // [ tx... ]
+    // [ output... ] (one per input, a null output for a coinbase input)
+    // The null output is also the marker of an unresolved previous output,
+    // distinguished from a coinbase input by its non-null point.
+    void complete()
+    {
+        const auto transaction = tx_->to_data(canonical);
+        data_stack outputs;
+        outputs.reserve(tx_->inputs().size());
+
+        for (const auto& input: tx_->inputs())
+            outputs.push_back(prevout(input).to_data());
+
+        const auto size = std::accumulate(outputs.begin(), outputs.end(),
+            code_size + transaction.size(),
+            [](size_t total, const data_chunk& output)
+            {
+                return total + output.size();
+            });
+
+        data_chunk result(size);
+        auto serial = make_unsafe_serializer(result.begin());
+        serial.write_error_code(error::success);
+        serial.write_bytes(transaction);
+
+        for (const auto& output: outputs)
+            serial.write_bytes(output);
+
+        handler_(message(request_, std::move(result)));
+    }
+
+    // Safe after all reads have completed.
+    const output& prevout(const input& input) const
+    {
+        static const output null_output{};
+        const auto& point = input.previous_output();
+
+        if (point.is_null())
+            return null_output;
+
+        const auto& previous = previous_.at(point.hash());
+
+        if (!previous)
+            return null_output;
+
+        const auto& outputs = previous->outputs();
+        return point.index() < outputs.size() ? outputs[point.index()] :
+            null_output;
+    }
+
+    server_node& node_;
+    const message request_;
+    const send_handler handler_;
+    const transaction_const_ptr tx_;
+
+    // These are protected by mutex.
+    size_t pending_;
+    bool failed_;
+    std::map<hash_digest, transaction_const_ptr> previous_;
+    std::mutex mutex_;
+};
+
+// Spend batch limits.
+static constexpr size_t maximum_spend_points = 1000;
+
+// This class is thread safe.
+// Fetches the spender of each output point with concurrent store reads and
+// responds once all have completed, with each result in point order.
+class spend_batch
+  : public std::enable_shared_from_this<spend_batch>
+{
+public:
+    spend_batch(server_node& node, const message& request,
+        send_handler handler, output_point::list&& points)
+      : node_(node),
+        request_(request),
+        handler_(handler),
+        points_(std::move(points)),
+        pending_(points_.size()),
+        codes_(points_.size()),
+        spenders_(points_.size())
+    {
+    }
+
+    void start()
+    {
+        if (points_.empty())
+        {
+            complete();
+            return;
+        }
+
+        const auto self = shared_from_this();
+
+        for (size_t index = 0; index < points_.size(); ++index)
+            node_.chain().fetch_spend(points_[index],
+                std::bind(&spend_batch::handle_fetched,
+                    self, _1, _2, index));
+    }
+
+private:
+    void handle_fetched(const code& ec, const input_point& inpoint,
+        size_t index)
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+
+        codes_[index] = ec;
+        spenders_[index] = inpoint;
+        const auto completed = (--pending_ == 0);
+
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        if (completed)
+            complete();
+    }
+
+    // An unspent output is indicated by not_found (with a null inpoint).
+    // [ code:4 ]
+    // [[ code:4 ][ hash:32 ][ index:4 ]]... (one per output point)
+    void complete()
+    {
+        static constexpr size_t record_size = code_size + point_size;
+        data_chunk result(code_size + record_size * points_.size());
+        auto serial = make_unsafe_serializer(result.begin());
+        serial.write_error_code(error::success);
+
+        for (size_t index = 0; index < points_.size(); ++index)
+        {
+            serial.write_error_code(codes_[index]);
+            spenders_[index].to_data(serial);
+        }
+
+        handler_(message(request_, std::move(result)));
+    }
+
+    server_node& node_;
+    const message request_;
+    const send_handler handler_;
+    const output_point::list points_;
+
+    // These are protected by mutex.
+    size_t pending_;
+    std::vector<code> codes_;
+    input_point::list spenders_;
+    std::mutex mutex_;
+};
+
+// Compact filter range limits (as BIP157 getcfilters).
+static constexpr size_t maximum_filters = 1000;
+
+// This class is thread safe.
+// Fetches the compact filters of a range of heights with concurrent store
+// reads and responds once all have completed, each with its filter header.
+class filter_range
+  : public std::enable_shared_from_this<filter_range>
+{
+public:
+    filter_range(server_node& node, const message& request,
+        send_handler handler, uint8_t filter_type, size_t start,
+        const compact_filter_headers& headers)
+      : node_(node),
+        request_(request),
+        handler_(handler),
+        filter_type_(filter_type),
+        start_(start),
+        headers_(to_headers(headers)),
+        pending_(headers_.size()),
+        failed_(false),
+        filters_(headers_.size())
+    {
+    }
+
+    void start()
+    {
+        if (headers_.empty())
+        {
+            complete();
+            return;
+        }
+
+        const auto self = shared_from_this();
+
+        for (size_t index = 0; index < headers_.size(); ++index)
+            node_.chain().fetch_compact_filter(filter_type_, start_ + index,
+                std::bind(&filter_range::handle_fetched,
+                    self, _1, _2, _3));
+    }
+
+private:
+    // BIP157: header = double_sha256(filter_hash || previous_header).
+    static hash_list to_headers(const compact_filter_headers& headers)
+    {
+        const auto& hashes = headers.filter_hashes();
+        const auto count = std::min(hashes.size(), maximum_filters);
+        auto previous = headers.previous_filter_header();
+        hash_list result;
+        result.reserve(count);
+
+        for (size_t index = 0; index < count; ++index)
+        {
+            previous = bitcoin_hash(build_chunk({ hashes[index], previous }));
+            result.push_back(previous);
+        }
+
+        return result;
+    }
+
+    void handle_fetched(const code& ec, compact_filter_ptr filter,
+        size_t height)
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+
+        if (failed_)
+        {
+            mutex_.unlock();
+            return;
+        }
+
+        if (ec)
+        {
+            failed_ = true;
+            mutex_.unlock();
+            handler_(message(request_, ec));
+            return;
+        }
+
+        filters_[height - start_] = filter->to_data(canonical);
+        const auto completed = (--pending_ == 0);
+
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        if (completed)
+            complete();
+    }
+
+    // [ code:4 ]
+    // [ count:4 ]
+    // [[ header:32 ][ compact filter... ]]...
+    void complete()
+    {
+        const auto size = std::accumulate(filters_.begin(), filters_.end(),
+            code_size + sizeof(uint32_t) + hash_size * headers_.size(),
+            [](size_t total, const data_chunk& filter)
+            {
+                return total + filter.size();
+            });
+
+        data_chunk result(size);
+        auto serial = make_unsafe_serializer(result.begin());
+        serial.write_error_code(error::success);
+        serial.write_4_bytes_little_endian(
+            static_cast<uint32_t>(headers_.size()));
+
+        for (size_t index = 0; index < headers_.size(); ++index)
+        {
+            serial.write_hash(headers_[index]);
+            serial.write_bytes(filters_[index]);
+        }
+
+        handler_(message(request_, std::move(result)));
+    }
+
+    server_node& node_;
+    const message request_;
+    const send_handler handler_;
+    const uint8_t filter_type_;
+    const size_t start_;
+    const hash_list headers_;
+
+    // These are protected by mutex.
+    size_t pending_;
+    bool failed_;
+    data_stack filters_;
+    std::mutex mutex_;
+};
+
+// Filter match limits.
+static constexpr size_t maximum_match_heights = 2000;
+static constexpr size_t maximum_match_elements = 1000;
+static constexpr size_t match_chunk_heights = 100;
+
+// This class is thread safe.
+// Matches an element set against the basic filters of a range of heights.
+// The range is dispatched in chunks to the node threadpool, so no filter is
+// matched on the query worker. Cached filters are matched by the chunk and
+// the others upon completion of their concurrent store reads.
+class filter_match
+  : public std::enable_shared_from_this<filter_match>
+{
+public:
+    filter_match(server_node& node, const message& request,
+        send_handler handler, size_t start, size_t stop,
+        data_stack&& elements)
+      : node_(node),
+        request_(request),
+        handler_(handler),
+        start_(start),
+        stop_(stop),
+        matcher_(std::move(elements)),
+        pending_(stop - start + 1u),
+        failed_(false),
+        matches_(stop - start + 1u, false)
+    {
+    }
+
+    void start()
+    {
+        const auto self = shared_from_this();
+        auto& service = node_.thread_pool().service();
+
+        for (auto first = start_; first <= stop_;
+            first += match_chunk_heights)
+        {
+            const auto last = std::min(stop_,
+                first + match_chunk_heights - 1u);
+
+            service.post(
+                std::bind(&filter_match::match_chunk,
+                    self, first, last));
+        }
+    }
+
+private:
+    void match_chunk(size_t first, size_t last)
+    {
+        const auto self = shared_from_this();
+        hash_digest block_hash;
+        data_chunk filter;
+
+        for (auto height = first; height <= last; ++height)
+        {
+            if (node_.filters().get_filter(block_hash, filter, height))
+                handle_matched(error::success,
+                    matcher_.match(block_hash, filter), height);
+            else
+                node_.chain().fetch_compact_filter(filter_cache::filter_type,
+                    height, std::bind(&filter_match::handle_fetched,
+                        self, _1, _2, _3));
+        }
+    }
+
+    void handle_fetched(const code& ec, compact_filter_ptr filter,
+        size_t height)
+    {
+        const auto matched = !ec &&
+            matcher_.match(filter->block_hash(), filter->filter());
+
+        handle_matched(ec, matched, height);
+    }
+
+    void handle_matched(const code& ec, bool matched, size_t height)
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+
+        if (failed_)
+        {
+            mutex_.unlock();
+            return;
+        }
+
+        if (ec)
+        {
+            failed_ = true;
+            mutex_.unlock();
+            handler_(message(request_, ec));
+            return;
+        }
+
+        matches_[height - start_] = matched;
+        const auto completed = (--pending_ == 0);
+
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        if (completed)
+            complete();
+    }
+
+    // [ code:4 ]
+    // [ stop_height:4 ]
+    // [ count:4 ]
+    // [ height:4 ]... (ascending)
+    void complete()
+    {
+        const auto count = static_cast<size_t>(
+            std::count(matches_.begin(), matches_.end(), true));
+
+        data_chunk result(code_size + 2u * sizeof(uint32_t) +
+            count * sizeof(uint32_t));
+        auto serial = make_unsafe_serializer(result.begin());
+        serial.write_error_code(error::success);
+        serial.write_4_bytes_little_endian(static_cast<uint32_t>(stop_));
+        serial.write_4_bytes_little_endian(static_cast<uint32_t>(count));
+
+        for (size_t index = 0; index < matches_.size(); ++index)
+            if (matches_[index])
+                serial.write_4_bytes_little_endian(
+                    static_cast<uint32_t>(start_ + index));
+
+        handler_(message(request_, std::move(result)));
+    }
+
+    server_node& node_;
+    const message request_;
+    const send_handler handler_;
+    const size_t start_;
+    const size_t stop_;
+    const filter_matcher matcher_;
+
+    // These are protected by mutex.
+    size_t pending_;
+    bool failed_;
+    std::vector<bool> matches_;
+    std::mutex mutex_;
+};
+
+// This class is thread safe.
+// Completes a header range beyond the header cache with store reads, a bounded
+// number outstanding, responding with the cached headers followed by those
+// read, through the first height not found.
+class header_range
+  : public std::enable_shared_from_this<header_range>
+{
+public:
+    header_range(server_node& node, const message& request,
+        send_handler handler, data_chunk&& result, size_t start, size_t count)
+      : node_(node),
+        request_(request),
+        handler_(handler),
+        start_(start),
+        next_fetch_(start),
+        stop_(start + count),
+        pending_(0),
+        result_(std::move(result)),
+        headers_(count)
+    {
+    }
+
+    void start()
+    {
+        fetch(next_heights());
+    }
+
+private:
+    typedef std::vector<size_t> heights;
+
+    // Call under lock (or before concurrency).
+    heights next_heights()
+    {
+        heights out;
+
+        for (; next_fetch_ < stop_ && pending_ < range_read_ahead; ++pending_)
+            out.push_back(next_fetch_++);
+
+        return out;
+    }
+
+    void fetch(const heights& values)
+    {
+        const auto self = shared_from_this();
+
+        for (const auto height: values)
+            node_.chain().fetch_block_header(height,
+                std::bind(&header_range::handle_fetched,
+                    self, _1, _2, height));
+    }
+
+    void handle_fetched(const code& ec, header_const_ptr header,
+        size_t height)
+    {
+        heights values;
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+
+        // A failed read truncates the range at its height.
+        if (ec)
+            stop_ = std::min(stop_, height);
+        else
+            headers_[height - start_] = header;
+
+        --pending_;
+        values = next_heights();
+        const auto completed = (pending_ == 0);
+
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        if (completed)
+            complete();
+        else
+            fetch(values);
+    }
+
+    // [ code:4 ]
+    // [[ header:80 ]...]
+    void complete()
+    {
+        for (const auto& header: headers_)
+        {
+            if (!header)
+                break;
+
+            extend_data(result_, header->to_data(canonical));
+        }
+
+        const auto found = result_.size() > code_size;
+        auto serial = make_unsafe_serializer(result_.begin());
+        serial.write_error_code(found ? error::success : error::not_found);
+        handler_(message(request_, std::move(result_)));
+    }
+
+    server_node& node_;
+    const message request_;
+    const send_handler handler_;
+    const size_t start_;
+
+    // These are protected by mutex.
+    size_t next_fetch_;
+    size_t stop_;
+    size_t pending_;
+    data_chunk result_;
+    std::vector<header_const_ptr> headers_;
+    std::mutex mutex_;
+};
+
 // TODO: create interface doc for unordered list, unconfirmeds and key change.
 void blockchain::fetch_history4(server_node& node, const message& request,
     send_handler handler)
 {
-    static constexpr size_t default_limit = 0;
     static constexpr size_t history_args_size = hash_size + sizeof(uint32_t);
 
     const auto& data = request.data();
@@ -62,7 +814,7 @@ void blockchain::fetch_history4(server_node& node, const message& request,
     const auto key = deserial.read_reverse<hash_digest>();
     const size_t from_height = deserial.read_4_bytes_little_endian();
 
-    node.chain().fetch_history(key, default_limit, from_height,
+    node.fetch_history(key, from_height,
         std::bind(&blockchain::history_fetched,
             _1, _2, request, handler));
 }
@@ -83,6 +835,541 @@ void blockchain::history_fetched(const code& ec,
     handler(message(request, std::move(result)));
 }
 
+// [ key:32 ]
+// [ from_height:4 ]
+// [ options:1 ] (bit 0: include transactions)
+void blockchain::fetch_history5(server_node& node, const message& request,
+    send_handler handler)
+{
+    static constexpr uint8_t include_transactions = 0x01;
+    static constexpr size_t history_args_size = hash_size +
+        sizeof(uint32_t) + sizeof(uint8_t);
+
+    const auto& data = request.data();
+
+    if (data.size() != history_args_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const auto key = deserial.read_reverse<hash_digest>();
+    const size_t from_height = deserial.read_4_bytes_little_endian();
+    const auto options = deserial.read_byte();
+
+    node.fetch_history(key, from_height,
+        std::bind(&blockchain::history5_fetched,
+            _1, _2, std::ref(node), request, handler,
+            (options & include_transactions) != 0));
+}
+
+void blockchain::history5_fetched(const code& ec,
+    const payment_record::list& payments, server_node& node,
+    const message& request, send_handler handler, bool include_transactions)
+{
+    static const auto record_size = payment_record::satoshi_fixed_size(true);
+
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    // [ count:4 ]
+    // [ record... ]
+    data_chunk records(sizeof(uint32_t) + record_size * payments.size());
+    auto serial = make_unsafe_serializer(records.begin());
+    serial.write_4_bytes_little_endian(safe_unsigned<uint32_t>(
+        payments.size()));
+
+    // Unconfirmed transactions have height sentinal of max_uint32.
+    for (const auto& record: payments)
+        record.to_data(serial, true);
+
+    if (!include_transactions)
+    {
+        handler(message(request, build_chunk(
+        {
+            message::to_bytes(error::success),
+            records
+        })));
+
+        return;
+    }
+
+    // A transaction is commonly referenced by both output and spend records.
+    hash_list hashes;
+    std::unordered_set<hash_digest> distinct;
+
+    for (const auto& record: payments)
+        if (distinct.insert(record.hash()).second)
+            hashes.push_back(record.hash());
+
+    // The history includes unconfirmed transactions.
+    const auto require_confirmed = false;
+    const auto witness = script::is_enabled(
+        node.blockchain_settings().enabled_forks(), rule_fork::bip141_rule);
+
+    transaction_batch::fetch(node, std::move(hashes), require_confirmed,
+        witness, std::bind(&blockchain::history_transactions_fetched,
+            _1, _2, _3, std::move(records), request, handler));
+}
+
+// [ code:4 ]
+// [ count:4 ]
+// [ record... ]
+// [[ hash:32 ][ size:varint ][ tx... ]]... (distinct, in record order)
+// A transaction that cannot be read has a size of zero.
+void blockchain::history_transactions_fetched(
+    const transaction_batch::code_list& codes,
+    const transaction_batch::transaction_list& transactions,
+    const hash_list& hashes, const data_chunk& records,
+    const message& request, send_handler handler)
+{
+    data_stack datas;
+    datas.reserve(transactions.size());
+    auto size = code_size + records.size();
+
+    for (size_t index = 0; index < transactions.size(); ++index)
+    {
+        datas.push_back(codes[index] ? data_chunk{} :
+            transactions[index]->to_data(canonical));
+
+        const auto length = datas.back().size();
+        size += hash_size + variable_uint_size(length) + length;
+    }
+
+    data_chunk result(size);
+    auto serial = make_unsafe_serializer(result.begin());
+    serial.write_error_code(error::success);
+    serial.write_bytes(records);
+
+    for (size_t index = 0; index < datas.size(); ++index)
+    {
+        serial.write_hash(hashes[index]);
+        serial.write_variable_little_endian(datas[index].size());
+        serial.write_bytes(datas[index]);
+    }
+
+    handler(message(request, std::move(result)));
+}
+
+// [ key:32 ]
+// [ from_height:4 ]
+void blockchain::fetch_history6(server_node& node, const message& request,
+    send_handler handler)
+{
+    static constexpr size_t history_args_size = hash_size + sizeof(uint32_t);
+
+    const auto& data = request.data();
+
+    if (data.size() != history_args_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const auto key = deserial.read_reverse<hash_digest>();
+    const size_t from_height = deserial.read_4_bytes_little_endian();
+
+    node.fetch_history(key, from_height,
+        std::bind(&blockchain::history6_fetched,
+            _1, _2, request, handler));
+}
+
+// [ code:4 ]
+// [ history... ] (see history_encoder)
+void blockchain::history6_fetched(const code& ec,
+    const payment_record::list& payments, const message& request,
+    send_handler handler)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    // The encoding is written following a zeroed (success) code.
+    handler(message(request, history_encoder::encode(payments, code_size)));
+}
+
+// [ key:32 ]
+// [ min_conf:4 ]
+void blockchain::fetch_unspent(server_node& node, const message& request,
+    send_handler handler)
+{
+    static constexpr size_t default_from_height = 0;
+    static constexpr size_t unspent_args_size = hash_size + sizeof(uint32_t);
+
+    const auto& data = request.data();
+
+    if (data.size() != unspent_args_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const auto key = deserial.read_reverse<hash_digest>();
+    const size_t min_conf = deserial.read_4_bytes_little_endian();
+
+    node.fetch_history(key, default_from_height,
+        std::bind(&blockchain::unspent_history_fetched,
+            _1, _2, std::ref(node), request, handler, min_conf));
+}
+
+// Outputs are paired with spends by point checksum, as the history records
+// of spends carry the checksum of the spent point in place of a value. The
+// history includes unconfirmed (pool) outputs and spends.
+void blockchain::unspent_history_fetched(const code& ec,
+    const payment_record::list& payments, server_node& node,
+    const message& request, send_handler handler, size_t min_conf)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    size_t top = 0;
+    if (min_conf > 0 && !node.chain().get_top_height(top, false))
+    {
+        handler(message(request, error::operation_failed));
+        return;
+    }
+
+    std::unordered_set<uint64_t> spent;
+
+    for (const auto& record: payments)
+        if (!record.is_output())
+            spent.insert(record.data());
+
+    // Unconfirmed outputs have a height of max_uint32 (zero confirmations).
+    const auto confirmed = [&](const payment_record& record)
+    {
+        return min_conf == 0 || (record.height() <= top &&
+            top - record.height() + 1 >= min_conf);
+    };
+
+    payment_record::list unspent;
+    hash_list hashes;
+    std::unordered_set<hash_digest> distinct;
+
+    for (const auto& record: payments)
+    {
+        if (!record.is_output() || !confirmed(record))
+            continue;
+
+        const output_point point{ record.hash(), record.index() };
+
+        if (spent.find(point.checksum()) != spent.end())
+            continue;
+
+        unspent.push_back(record);
+
+        if (distinct.insert(record.hash()).second)
+            hashes.push_back(record.hash());
+    }
+
+    // Output scripts are not part of the history, so are read from the txs.
+    const auto require_confirmed = false;
+    const auto witness = false;
+
+    transaction_batch::fetch(node, std::move(hashes), require_confirmed,
+        witness, std::bind(&blockchain::unspent_transactions_fetched,
+            _1, _2, _3, std::move(unspent), request, handler));
+}
+
+// An output whose transaction cannot be read is listed as unresolved, with
+// the value of its history record, so that one failed read does not fail the
+// response and the listed values still sum to the balance.
+// [ code:4 ]
+// [ count:4 ]
+// [[ hash:32 ][ index:4 ][ height:4 ][ value:8 ][ script:varint... ]]...
+// [ unresolved_count:4 ]
+// [[ hash:32 ][ index:4 ][ height:4 ][ value:8 ]]...
+void blockchain::unspent_transactions_fetched(
+    const transaction_batch::code_list& codes,
+    const transaction_batch::transaction_list& transactions,
+    const hash_list& hashes, const payment_record::list& unspent,
+    const message& request, send_handler handler)
+{
+    static constexpr size_t unresolved_size = point_size + sizeof(uint32_t) +
+        sizeof(uint64_t);
+
+    std::unordered_map<hash_digest, transaction_const_ptr> map;
+
+    for (size_t index = 0; index < hashes.size(); ++index)
+        if (!codes[index])
+            map.emplace(hashes[index], transactions[index]);
+
+    std::vector<size_t> resolved;
+    std::vector<size_t> unresolved;
+    data_stack outputs;
+    outputs.reserve(unspent.size());
+    auto size = code_size + 2u * sizeof(uint32_t);
+
+    for (size_t index = 0; index < unspent.size(); ++index)
+    {
+        const auto& record = unspent[index];
+        const auto it = map.find(record.hash());
+
+        if (it == map.end() ||
+            record.index() >= it->second->outputs().size())
+        {
+            unresolved.push_back(index);
+            size += unresolved_size;
+            continue;
+        }
+
+        resolved.push_back(index);
+        outputs.push_back(it->second->outputs()[record.index()].to_data());
+        size += point_size + sizeof(uint32_t) + outputs.back().size();
+    }
+
+    data_chunk result(size);
+    auto serial = make_unsafe_serializer(result.begin());
+    serial.write_error_code(error::success);
+    serial.write_4_bytes_little_endian(safe_unsigned<uint32_t>(
+        resolved.size()));
+
+    for (size_t position = 0; position < resolved.size(); ++position)
+    {
+        const auto& record = unspent[resolved[position]];
+        serial.write_hash(record.hash());
+        serial.write_4_bytes_little_endian(record.index());
+        serial.write_4_bytes_little_endian(record.height());
+
+        // [ value:8 ][ script:varint... ]
+        serial.write_bytes(outputs[position]);
+    }
+
+    serial.write_4_bytes_little_endian(safe_unsigned<uint32_t>(
+        unresolved.size()));
+
+    for (const auto index: unresolved)
+    {
+        const auto& record = unspent[index];
+        serial.write_hash(record.hash());
+        serial.write_4_bytes_little_endian(record.index());
+        serial.write_4_bytes_little_endian(record.height());
+        serial.write_8_bytes_little_endian(record.data());
+    }
+
+    handler(message(request, std::move(result)));
+}
+
+// [ key:32 ]
+void blockchain::fetch_balance(server_node& node, const message& request,
+    send_handler handler)
+{
+    fetch_aggregate(node, request, handler, &blockchain::balance_fetched);
+}
+
+// [ key:32 ]
+void blockchain::fetch_history_status(server_node& node,
+    const message& request, send_handler handler)
+{
+    fetch_aggregate(node, request, handler, &blockchain::status_fetched);
+}
+
+// Aggregates are served from the balance cache, populated upon first query.
+void blockchain::fetch_aggregate(server_node& node, const message& request,
+    send_handler handler, aggregate_handler reply)
+{
+    const auto& data = request.data();
+
+    if (data.size() != hash_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const auto key = deserial.read_reverse<hash_digest>();
+
+    node.fetch_balance(key,
+        std::bind(&blockchain::aggregate_fetched,
+            _1, _2, request, handler, reply));
+}
+
+void blockchain::aggregate_fetched(const code& ec,
+    const balance_cache::balance& balance, const message& request,
+    send_handler handler, aggregate_handler reply)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    reply(balance, request, handler);
+}
+
+// Delta flags.
+static constexpr uint8_t delta_unchanged = 0x01;
+static constexpr uint8_t delta_full = 0x02;
+
+// [ key:32 ]
+// [ sync_height:4 ]
+// [ sync_status:32 ]
+// The sync height is the confirmed top at the time of the last sync, and the
+// sync status is the history status returned by that sync.
+void blockchain::fetch_history_delta(server_node& node,
+    const message& request, send_handler handler)
+{
+    static constexpr size_t delta_args_size = hash_size + sizeof(uint32_t) +
+        hash_size;
+
+    const auto& data = request.data();
+
+    if (data.size() != delta_args_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const auto key = deserial.read_reverse<hash_digest>();
+    const size_t sync_height = deserial.read_4_bytes_little_endian();
+    const auto sync_status = deserial.read_hash();
+
+    node.fetch_balance(key,
+        std::bind(&blockchain::delta_status_fetched,
+            _1, _2, std::ref(node), request, handler, key, sync_height,
+            sync_status));
+}
+
+void blockchain::delta_status_fetched(const code& ec,
+    const balance_cache::balance& balance, server_node& node,
+    const message& request, send_handler handler, const hash_digest& key,
+    size_t sync_height, const hash_digest& sync_status)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    if (balance.status == sync_status)
+    {
+        delta_history_fetched(error::success, {}, request, handler,
+            balance.status, delta_unchanged, sync_height, {});
+        return;
+    }
+
+    // A sync point below the journal requires the full history.
+    size_t from = 0;
+    uint8_t flags = 0;
+    reorg_journal::removal_list removals;
+
+    if (!node.reorganizations().removed(removals, from, key, sync_height))
+    {
+        from = 0;
+        flags = delta_full;
+        removals.clear();
+    }
+
+    // Unconfirmed records are always included, confirmed are above from.
+    const auto from_height = flags == delta_full ? 0 : from + 1;
+
+    node.fetch_history(key, from_height,
+        std::bind(&blockchain::delta_history_fetched,
+            _1, _2, request, handler, balance.status, flags, from,
+            std::move(removals)));
+}
+
+// The client removes the removals and its unconfirmed records, or all of its
+// records if full, and then adds the records. Confirmed records are those
+// above from, unconfirmed records are all of those in the pool.
+// [ code:4 ]
+// [ status:32 ]
+// [ flags:1 ] (bit 0: unchanged, bit 1: full)
+// [ from:4 ]
+// [ count:4 ]
+// [ record... ]
+// [ count:4 ]
+// [[ hash:32 ][ height:4 ]]... (removals)
+void blockchain::delta_history_fetched(const code& ec,
+    const payment_record::list& payments, const message& request,
+    send_handler handler, const hash_digest& status, uint8_t flags,
+    size_t from, const reorg_journal::removal_list& removals)
+{
+    static const auto record_size = payment_record::satoshi_fixed_size(true);
+    static constexpr size_t removal_size = hash_size + sizeof(uint32_t);
+
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    data_chunk result(code_size + hash_size + sizeof(uint8_t) +
+        3 * sizeof(uint32_t) + record_size * payments.size() +
+        removal_size * removals.size());
+    auto serial = make_unsafe_serializer(result.begin());
+    serial.write_error_code(error::success);
+    serial.write_hash(status);
+    serial.write_byte(flags);
+    serial.write_4_bytes_little_endian(safe_unsigned<uint32_t>(from));
+    serial.write_4_bytes_little_endian(safe_unsigned<uint32_t>(
+        payments.size()));
+
+    for (const auto& record: payments)
+        record.to_data(serial, true);
+
+    serial.write_4_bytes_little_endian(safe_unsigned<uint32_t>(
+        removals.size()));
+
+    for (const auto& removal: removals)
+    {
+        serial.write_hash(removal.tx_hash);
+        serial.write_4_bytes_little_endian(safe_unsigned<uint32_t>(
+            removal.height));
+    }
+
+    handler(message(request, std::move(result)));
+}
+
+// [ code:4 ]
+// [ status:32 ] (null if the key has no history)
+void blockchain::status_fetched(const balance_cache::balance& balance,
+    const message& request, send_handler handler)
+{
+    handler(message(request, build_chunk(
+    {
+        message::to_bytes(error::success),
+        balance.status
+    })));
+}
+
+// [ code:4 ]
+// [ confirmed:8 ]
+// [ unconfirmed:8 ] (signed)
+// [ transactions:4 ] (confirmed)
+// [ first_height:4 ]
+// [ last_height:4 ]
+void blockchain::balance_fetched(const balance_cache::balance& balance,
+    const message& request, send_handler handler)
+{
+    static constexpr size_t balance_size = code_size + 2 * sizeof(uint64_t) +
+        3 * sizeof(uint32_t);
+
+    data_chunk result(balance_size);
+    auto serial = make_unsafe_serializer(result.begin());
+    serial.write_error_code(error::success);
+    serial.write_8_bytes_little_endian(balance.confirmed);
+    serial.write_8_bytes_little_endian(
+        static_cast<uint64_t>(balance.unconfirmed));
+    serial.write_4_bytes_little_endian(balance.transactions);
+    serial.write_4_bytes_little_endian(balance.first_height);
+    serial.write_4_bytes_little_endian(balance.last_height);
+
+    handler(message(request, std::move(result)));
+}
+
 void blockchain::fetch_transaction(server_node& node, const message& request,
     send_handler handler)
 {
@@ -102,13 +1389,71 @@ void blockchain::fetch_transaction(server_node& node, const message& request,
     const auto require_confirmed = true;
     const auto witness = false;
 
-    node.chain().fetch_transaction(hash, require_confirmed, witness,
-        std::bind(&blockchain::transaction_fetched,
-            _1, _2, _3, _4, request, handler));
+    node.chain().fetch_transaction(hash, require_confirmed, witness,
+        std::bind(&blockchain::transaction_fetched,
+            _1, _2, _3, _4, request, handler));
+}
+
+void blockchain::fetch_transaction2(server_node& node, const message& request,
+    send_handler handler)
+{
+    const auto& data = request.data();
+
+    if (data.size() != hash_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const auto hash = deserial.read_hash();
+
+    // The response is restricted to confirmed transactions.
+    // This response can include witness data (based on configuration)
+    // so may break old parsers.
+    const auto require_confirmed = true;
+    const auto witness = script::is_enabled(
+        node.blockchain_settings().enabled_forks(), rule_fork::bip141_rule);
+
+    node.chain().fetch_transaction(hash, require_confirmed, witness,
+        std::bind(&blockchain::transaction_fetched,
+            _1, _2, _3, _4, request, handler));
+}
+
+// [ hash:32 ]... (1 to 100)
+void blockchain::fetch_transactions(server_node& node, const message& request,
+    send_handler handler)
+{
+    // The response is restricted to confirmed transactions.
+    const auto require_confirmed = true;
+    const auto witness = script::is_enabled(
+        node.blockchain_settings().enabled_forks(), rule_fork::bip141_rule);
+
+    transaction_batch::fetch(node, request, handler, require_confirmed,
+        witness);
+}
+
+void blockchain::transaction_fetched(const code& ec, transaction_const_ptr tx,
+    size_t, size_t, const message& request, send_handler handler)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    auto result = build_chunk(
+    {
+        message::to_bytes(error::success),
+        tx->to_data(canonical)
+    });
+
+    handler(message(request, std::move(result)));
 }
 
-void blockchain::fetch_transaction2(server_node& node, const message& request,
-    send_handler handler)
+// [ hash:32 ]
+void blockchain::fetch_transaction_with_prevouts(server_node& node,
+    const message& request, send_handler handler)
 {
     const auto& data = request.data();
 
@@ -121,20 +1466,19 @@ void blockchain::fetch_transaction2(server_node& node, const message& request,
     auto deserial = make_safe_deserializer(data.begin(), data.end());
     const auto hash = deserial.read_hash();
 
-    // The response is restricted to confirmed transactions.
-    // This response can include witness data (based on configuration)
-    // so may break old parsers.
-    const auto require_confirmed = true;
+    // Pool transactions are allowed, their previous outputs may be pooled.
+    const auto require_confirmed = false;
     const auto witness = script::is_enabled(
         node.blockchain_settings().enabled_forks(), rule_fork::bip141_rule);
 
     node.chain().fetch_transaction(hash, require_confirmed, witness,
-        std::bind(&blockchain::transaction_fetched,
-            _1, _2, _3, _4, request, handler));
+        std::bind(&blockchain::transaction_with_prevouts_fetched,
+            _1, _2, _3, _4, std::ref(node), request, handler));
 }
 
-void blockchain::transaction_fetched(const code& ec, transaction_const_ptr tx,
-    size_t, size_t, const message& request, send_handler handler)
+void blockchain::transaction_with_prevouts_fetched(const code& ec,
+    transaction_const_ptr tx, size_t, size_t, server_node& node,
+    const message& request, send_handler handler)
 {
     if (ec)
     {
@@ -142,13 +1486,7 @@ void blockchain::transaction_fetched(const code& ec, transaction_const_ptr tx,
         return;
     }
 
-    auto result = build_chunk(
-    {
-        message::to_bytes(error::success),
-        tx->to_data(canonical)
-    });
-
-    handler(message(request, std::move(result)));
+    std::make_shared<prevout_resolver>(node, request, handler, tx)->start();
 }
 
 void blockchain::fetch_last_height(server_node& node, const message& request,
@@ -248,6 +1586,124 @@ void blockchain::compact_filter_fetched(const code& ec,
     handler(message(request, std::move(result)));
 }
 
+// The range is served from the filter cache when it holds the stop block.
+void blockchain::fetch_compact_filters(server_node& node,
+    const message& request, send_handler handler)
+{
+    static constexpr size_t filters_args_size = 1u + sizeof(uint32_t) +
+        hash_size;
+
+    const auto& data = request.data();
+
+    if (data.size() != filters_args_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const auto filter_type = deserial.read_byte();
+    const size_t start_height = deserial.read_4_bytes_little_endian();
+    const auto stop_hash = deserial.read_hash();
+
+    data_chunk records;
+    size_t count;
+
+    if (filter_type == filter_cache::filter_type &&
+        node.filters().get(records, count, start_height, stop_hash,
+            maximum_filters))
+    {
+        // [ code:4 ]
+        // [ count:4 ]
+        // [[ header:32 ][ compact filter... ]]...
+        auto result = build_chunk(
+        {
+            message::to_bytes(error::success),
+            to_little_endian(static_cast<uint32_t>(count)),
+            records
+        });
+
+        handler(message(request, std::move(result)));
+        return;
+    }
+
+    node.chain().fetch_compact_filter_headers(filter_type, start_height,
+        stop_hash, std::bind(&blockchain::compact_filter_range_fetched,
+            _1, _2, std::ref(node), filter_type, start_height, request,
+                handler));
+}
+
+void blockchain::compact_filter_range_fetched(const code& ec,
+    compact_filter_headers_ptr headers, server_node& node, uint8_t filter_type,
+    size_t start_height, const message& request, send_handler handler)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    std::make_shared<filter_range>(node, request, handler, filter_type,
+        start_height, *headers)->start();
+}
+
+// The range is truncated to the maximum and to the confirmed top, and the
+// response reports the stop height so that the client may continue from the
+// following height.
+void blockchain::match_filters(server_node& node, const message& request,
+    send_handler handler)
+{
+    const auto& data = request.data();
+
+    // [ start_height:4 ]
+    // [ stop_height:4 ]
+    // [ count:varint ]
+    // [[ size:varint ][ element... ]]... (output scripts)
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const size_t start_height = deserial.read_4_bytes_little_endian();
+    const size_t stop_height = deserial.read_4_bytes_little_endian();
+    const auto count = deserial.read_variable_little_endian();
+
+    if (!deserial || count == 0 || count > maximum_match_elements ||
+        start_height > stop_height)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    data_stack elements;
+    elements.reserve(count);
+
+    for (size_t index = 0; index < count; ++index)
+        elements.push_back(deserial.read_bytes(
+            deserial.read_variable_little_endian()));
+
+    if (!deserial || !deserial.is_exhausted())
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    size_t top;
+    if (!node.chain().get_top_height(top, false))
+    {
+        handler(message(request, error::operation_failed));
+        return;
+    }
+
+    if (start_height > top)
+    {
+        handler(message(request, error::not_found));
+        return;
+    }
+
+    const auto stop = std::min(std::min(stop_height, top),
+        start_height + maximum_match_heights - 1u);
+
+    std::make_shared<filter_match>(node, request, handler, start_height,
+        stop, std::move(elements))->start();
+}
+
 void blockchain::fetch_compact_filter_headers(server_node& node,
     const message& request, send_handler handler)
 {
@@ -424,6 +1880,19 @@ void blockchain::fetch_block_header_by_hash(server_node& node,
     auto deserial = make_safe_deserializer(data.begin(), data.end());
     const auto block_hash = deserial.read_hash();
 
+    // Confirmed headers are served from the cache if enabled.
+    size_t height;
+    if (node.headers().get_height(height, block_hash))
+    {
+        auto result = message::to_bytes(error::success);
+
+        if (node.headers().get_header(result, height))
+        {
+            handler(message(request, std::move(result)));
+            return;
+        }
+    }
+
     node.chain().fetch_block_header(block_hash,
         std::bind(&blockchain::block_header_fetched,
             _1, _2, request, handler));
@@ -438,11 +1907,117 @@ void blockchain::fetch_block_header_by_height(server_node& node,
     auto deserial = make_safe_deserializer(data.begin(), data.end());
     const uint64_t height = deserial.read_4_bytes_little_endian();
 
+    // Confirmed headers are served from the cache if enabled.
+    if (height < node.headers().size())
+    {
+        auto result = message::to_bytes(error::success);
+
+        if (node.headers().get_header(result, height))
+        {
+            handler(message(request, std::move(result)));
+            return;
+        }
+    }
+
     node.chain().fetch_block_header(height,
         std::bind(&blockchain::block_header_fetched,
             _1, _2, request, handler));
 }
 
+// [ start:4 ]
+// [ count:4 ]
+void blockchain::fetch_block_headers(server_node& node,
+    const message& request, send_handler handler)
+{
+    static constexpr size_t headers_args_size = 2 * sizeof(uint32_t);
+    static constexpr size_t maximum_headers = 2000;
+
+    const auto& data = request.data();
+
+    if (data.size() != headers_args_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const size_t start = deserial.read_4_bytes_little_endian();
+    const size_t requested = deserial.read_4_bytes_little_endian();
+
+    size_t top;
+    if (!node.chain().get_top_height(top, false))
+    {
+        handler(message(request, error::operation_failed));
+        return;
+    }
+
+    if (start > top)
+    {
+        handler(message(request, error::not_found));
+        return;
+    }
+
+    // The range is truncated to the confirmed top.
+    const auto count = std::min(std::min(maximum_headers, requested),
+        top - start + 1u);
+
+    // [ code:4 ]
+    // [[ header:80 ]...]
+    data_chunk result(code_size);
+    result.reserve(code_size + count * header_cache::header_size);
+    const auto found = node.headers().get_headers(result, start, count);
+
+    // A loaded cache holds the confirmed chain, otherwise (disabled or
+    // loading) the shortfall is read from the store, off of this thread.
+    if (found < count && !node.headers_loaded())
+    {
+        std::make_shared<header_range>(node, request, handler,
+            std::move(result), start + found, count - found)->start();
+        return;
+    }
+
+    auto serial = make_unsafe_serializer(result.begin());
+    serial.write_error_code(found == 0 ? error::not_found : error::success);
+    handler(message(request, std::move(result)));
+}
+
+// [ start:4 ]
+// [ end:4 ]
+// [ credits:4 ]
+// The client pulls the range [start, end) in windows of up to its credits
+// (bounded by the server), requesting the next window from the height that
+// terminates the previous one. Store reads run ahead of sends.
+void blockchain::fetch_block_range(server_node& node,
+    const message& request, send_handler handler)
+{
+    static constexpr size_t range_args_size = 3 * sizeof(uint32_t);
+
+    const auto& data = request.data();
+
+    if (data.size() != range_args_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const size_t start = deserial.read_4_bytes_little_endian();
+    const size_t end = deserial.read_4_bytes_little_endian();
+    const size_t credits = deserial.read_4_bytes_little_endian();
+
+    if (start >= end || credits == 0)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    const auto window = std::min(credits, maximum_range_credits);
+    const auto stop = std::min(end, start + window);
+
+    std::make_shared<block_range>(node, request, handler, start, stop)->
+        start();
+}
+
 void blockchain::block_fetched(const code& ec, block_const_ptr block,
     const message& request, send_handler handler)
 {
@@ -537,6 +2112,104 @@ void blockchain::merkle_block_fetched(const code& ec, merkle_block_ptr block,
     handler(message(request, std::move(result)));
 }
 
+// The cache sequence is read first, so that a tree read from a chain that is
+// reorganized while the proof is built is not cached.
+void blockchain::fetch_merkle_proof(server_node& node,
+    const message& request, send_handler handler)
+{
+    const auto& data = request.data();
+
+    if (data.size() != hash_size)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+    const auto hash = deserial.read_hash();
+    const auto sequence = node.merkle_trees().sequence();
+
+    // A merkle proof exists only for confirmed transactions.
+    const auto require_confirmed = true;
+
+    node.chain().fetch_transaction_position(hash, require_confirmed,
+        std::bind(&blockchain::merkle_position_fetched,
+            _1, _2, _3, std::ref(node), sequence, request, handler));
+}
+
+void blockchain::merkle_position_fetched(const code& ec, size_t tx_position,
+    size_t block_height, server_node& node, size_t sequence,
+    const message& request, send_handler handler)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    hash_list branch;
+    if (node.merkle_trees().get_branch(branch, block_height, tx_position))
+    {
+        send_merkle_proof(branch, tx_position, block_height, request,
+            handler);
+        return;
+    }
+
+    node.chain().fetch_merkle_block(block_height,
+        std::bind(&blockchain::merkle_tree_fetched,
+            _1, _2, _3, std::ref(node), tx_position, sequence, request,
+                handler));
+}
+
+void blockchain::merkle_tree_fetched(const code& ec, merkle_block_ptr block,
+    size_t height, server_node& node, size_t tx_position, size_t sequence,
+    const message& request, send_handler handler)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    if (tx_position >= block->hashes().size())
+    {
+        handler(message(request, error::not_found));
+        return;
+    }
+
+    const auto levels = merkle_cache::to_levels(block->hashes());
+    node.merkle_trees().put(height, levels, sequence);
+    send_merkle_proof(merkle_cache::to_branch(levels, tx_position),
+        tx_position, height, request, handler);
+}
+
+void blockchain::send_merkle_proof(const hash_list& branch,
+    size_t tx_position, size_t block_height, const message& request,
+    send_handler handler)
+{
+    BITCOIN_ASSERT(tx_position <= max_uint32);
+    BITCOIN_ASSERT(block_height <= max_uint32);
+    BITCOIN_ASSERT(branch.size() <= max_uint8);
+
+    // [ code:4 ]
+    // [ block_height:4 ]
+    // [ tx_position:4 ]
+    // [ count:1 ]
+    // [[ hash:32 ]...] (from the transaction to the root, excluded)
+    data_chunk result(code_size + 2u * sizeof(uint32_t) +
+        sizeof(uint8_t) + hash_size * branch.size());
+    auto serial = make_unsafe_serializer(result.begin());
+    serial.write_error_code(error::success);
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(block_height));
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(tx_position));
+    serial.write_byte(static_cast<uint8_t>(branch.size()));
+
+    for (const auto& hash: branch)
+        serial.write_hash(hash);
+
+    handler(message(request, std::move(result)));
+}
+
 void blockchain::fetch_transaction_index(server_node& node,
     const message& request, send_handler handler)
 {
@@ -618,6 +2291,78 @@ void blockchain::spend_fetched(const code& ec, const input_point& inpoint,
     handler(message(request, std::move(result)));
 }
 
+// [ hash:32 ] (all outputs of the transaction, up to 1000)
+// or
+// [[ hash:32 ][ index:4 ]]... (1 to 1000 output points)
+void blockchain::fetch_spends(server_node& node, const message& request,
+    send_handler handler)
+{
+    const auto& data = request.data();
+
+    if (data.size() == hash_size)
+    {
+        auto deserial = make_safe_deserializer(data.begin(), data.end());
+        const auto hash = deserial.read_hash();
+
+        // Unconfirmed transactions are allowed, their outputs are unspent.
+        const auto require_confirmed = false;
+        const auto witness = false;
+
+        node.chain().fetch_transaction(hash, require_confirmed, witness,
+            std::bind(&blockchain::spends_transaction_fetched,
+                _1, _2, _3, _4, std::ref(node), request, handler));
+        return;
+    }
+
+    const auto count = data.size() / point_size;
+
+    if (data.empty() || data.size() % point_size != 0 ||
+        count > maximum_spend_points)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    output_point::list points(count);
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+
+    for (auto& point: points)
+        point.from_data(deserial);
+
+    std::make_shared<spend_batch>(node, request, handler, std::move(points))->
+        start();
+}
+
+void blockchain::spends_transaction_fetched(const code& ec,
+    transaction_const_ptr tx, size_t, size_t, server_node& node,
+    const message& request, send_handler handler)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    const auto& outputs = tx->outputs();
+
+    // The output count is limited as is the count of requested points.
+    if (outputs.size() > maximum_spend_points)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    const auto hash = tx->hash();
+    output_point::list points;
+    points.reserve(outputs.size());
+
+    for (uint32_t index = 0; index < outputs.size(); ++index)
+        points.emplace_back(hash, index);
+
+    std::make_shared<spend_batch>(node, request, handler, std::move(points))->
+        start();
+}
+
 void blockchain::fetch_block_height(server_node& node, const message& request,
     send_handler handler)
 {
@@ -631,6 +2376,15 @@ void blockchain::fetch_block_height(server_node& node, const message& request,
 
     auto deserial = make_safe_deserializer(data.begin(), data.end());
     const auto block_hash = deserial.read_hash();
+
+    // Confirmed heights are served from the cache if enabled.
+    size_t height;
+    if (node.headers().get_height(height, block_hash))
+    {
+        block_height_fetched(error::success, height, request, handler);
+        return;
+    }
+
     node.chain().fetch_block_height(block_hash,
         std::bind(&blockchain::block_height_fetched,
             _1, _2, request, handler));
@@ -18,6 +18,10 @@
  */
 #include <bitcoin/server/interface/server.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
 #include <bitcoin/system.hpp>
 #include <bitcoin/server/messages/message.hpp>
 #include <bitcoin/server/server_node.hpp>
@@ -30,6 +34,8 @@ namespace server {
 
 using namespace bc::system;
 
+static constexpr size_t code_size = sizeof(uint32_t);
+
 void server::version(server_node&, const message& request,
     send_handler handler)
 {
@@ -44,5 +50,45 @@ void server::version(server_node&, const message& request,
     handler(message(request, std::move(result)));
 }
 
+// [ code:4 ]
+// [ count:4 ]
+// [[ endpoint:varstring ][ sessions:4 ][ queued:8 ][ dropped:8 ]
+//  [ evicted:8 ]...]
+void server::fetch_websocket_metrics(server_node& node,
+    const message& request, send_handler handler)
+{
+    static constexpr size_t counters_size = sizeof(uint32_t) +
+        3 * sizeof(uint64_t);
+
+    const auto metrics = node.websocket_metrics();
+    std::vector<std::string> endpoints;
+    auto size = code_size + sizeof(uint32_t);
+
+    for (const auto& metric: metrics)
+    {
+        endpoints.push_back(metric.endpoint.to_string());
+        size += variable_uint_size(endpoints.back().size()) +
+            endpoints.back().size() + counters_size;
+    }
+
+    data_chunk result(size);
+    auto serial = make_unsafe_serializer(result.begin());
+    serial.write_error_code(error::success);
+    serial.write_4_bytes_little_endian(static_cast<uint32_t>(metrics.size()));
+
+    for (size_t index = 0; index < metrics.size(); ++index)
+    {
+        const auto& metric = metrics[index];
+        serial.write_string(endpoints[index]);
+        serial.write_4_bytes_little_endian(
+            static_cast<uint32_t>(metric.sessions));
+        serial.write_8_bytes_little_endian(metric.queued);
+        serial.write_8_bytes_little_endian(metric.dropped);
+        serial.write_8_bytes_little_endian(metric.evicted);
+    }
+
+    handler(message(request, std::move(result)));
+}
+
 } // namespace server
 } // namespace libbitcoin
@@ -31,26 +31,69 @@ namespace server {
 
 using namespace bc::system;
 using namespace bc::system::wallet;
+using namespace std::placeholders;
 
 void subscribe::key(server_node& node, const message& request,
     send_handler handler)
 {
+    static constexpr uint8_t include_status = 0x01;
     static constexpr size_t args_size = hash_size;
 
     const auto& data = request.data();
 
-    if (data.size() != args_size)
+    if (data.size() != args_size && data.size() != args_size + 1)
     {
         handler(message(request, error::bad_stream));
         return;
     }
 
     // [ key:32 ]
+    // [ options:1 ] (optional, bit 0: include status)
     auto deserial = make_safe_deserializer(data.begin(), data.end());
     auto key = deserial.read_hash();
+    const auto status = data.size() > args_size &&
+        (deserial.read_byte() & include_status) != 0;
 
-    auto ec = node.subscribe_key(request, std::move(key), false);
-    handler(message(request, ec));
+    if (!status)
+    {
+        const auto ec = node.subscribe_key(request, std::move(key), false,
+            false);
+        handler(message(request, ec));
+        return;
+    }
+
+    const auto ec = node.subscribe_key(request, hash_digest(key), false,
+        true);
+
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    // The status is cached so that subsequent notifications can carry it.
+    node.fetch_balance(key,
+        std::bind(&subscribe::status_fetched,
+            _1, _2, request, handler));
+}
+
+// [ code:4 ]
+// [ status:32 ]
+void subscribe::status_fetched(const code& ec,
+    const balance_cache::balance& balance, const message& request,
+    send_handler handler)
+{
+    if (ec)
+    {
+        handler(message(request, ec));
+        return;
+    }
+
+    handler(message(request, build_chunk(
+    {
+        message::to_bytes(error::success),
+        balance.status
+    })));
 }
 
 } // namespace server
@@ -25,6 +25,7 @@
 #include <bitcoin/server/configuration.hpp>
 #include <bitcoin/server/messages/message.hpp>
 #include <bitcoin/server/server_node.hpp>
+#include <bitcoin/server/utility/transaction_batch.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -76,6 +77,15 @@ void transaction_pool::fetch_transaction2(server_node& node,
             _1, _2, _3, _4, request, handler));
 }
 
+// [ hash:32 ]... (1 to 100)
+void transaction_pool::fetch_transactions(server_node& node,
+    const message& request, send_handler handler)
+{
+    // The response allows confirmed and unconfirmed transactions.
+    // This response includes witness data so may break old parsers.
+    transaction_batch::fetch(node, request, handler, false, true);
+}
+
 void transaction_pool::transaction_fetched(const code& ec,
     transaction_const_ptr tx, size_t, size_t, const message& request,
     send_handler handler)
@@ -99,27 +109,25 @@ void transaction_pool::transaction_fetched(const code& ec,
 
 // Save to tx pool and announce to all connected peers.
 // FUTURE: conditionally subscribe to penetration notifications.
-void transaction_pool::broadcast(server_node& /* node */, const message& request,
+void transaction_pool::broadcast(server_node& node, const message& request,
     send_handler handler)
 {
-    // TODO: re-implement.
-    handler(message(request, error::not_implemented));
+    const auto tx = std::make_shared<system::message::transaction>();
 
-    ////const auto tx = std::make_shared<bc::message::transaction>();
-
-    ////if (!tx->from_data(canonical, request.data()))
-    ////{
-    ////    handler(message(request, error::bad_stream));
-    ////    return;
-    ////}
+    if (!tx->from_data(canonical, request.data()))
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
 
-    ////// Organize into our chain.
-    ////tx->metadata.simulate = false;
+    // Organize into our chain.
+    tx->metadata.simulate = false;
 
-    ////// This call is async but blocks on other organizations until started.
-    ////// Subscribed channels will pick up and announce via tx inventory to peers.
-    ////node.chain().organize(tx,
-    ////    std::bind(handle_broadcast, _1, request, handler));
+    // Queued for organization, subscribed channels will pick up and announce
+    // via tx inventory to peers.
+    node.submissions().submit(tx,
+        std::bind(&transaction_pool::handle_broadcast,
+            _1, request, handler));
 }
 
 void transaction_pool::handle_broadcast(const code& ec, const message& request,
@@ -129,26 +137,24 @@ void transaction_pool::handle_broadcast(const code& ec, const message& request,
     handler(message(request, ec));
 }
 
-void transaction_pool::validate2(server_node& /* node */, const message& request,
+void transaction_pool::validate2(server_node& node, const message& request,
     send_handler handler)
 {
-    // TODO: re-implement.
-    handler(message(request, error::not_implemented));
-
-    ////const auto tx = std::make_shared<bc::message::transaction>();
+    const auto tx = std::make_shared<system::message::transaction>();
 
-    ////if (!tx->from_data(canonical, request.data()))
-    ////{
-    ////    handler(message(request, error::bad_stream));
-    ////    return;
-    ////}
+    if (!tx->from_data(canonical, request.data()))
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
 
-    ////// Simulate organization into our chain.
-    ////tx->metadata.simulate = true;
+    // Simulate organization into our chain.
+    tx->metadata.simulate = true;
 
-    ////// This call is async but blocks on other organizations until started.
-    ////node.chain().organize(tx,
-    ////    std::bind(handle_validated2, _1, request, handler));
+    // Queued for organization with broadcasts, in order of submission.
+    node.submissions().submit(tx,
+        std::bind(&transaction_pool::handle_validated2,
+            _1, request, handler));
 }
 
 void transaction_pool::handle_validated2(const code& ec,
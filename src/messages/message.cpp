@@ -120,7 +120,7 @@ bool message::secure() const
 // Transport.
 //-------------------------------------------------------------------------
 
-code message::receive(zmq::socket& socket)
+code message::receive(zmq::socket& socket, const validator& validate)
 {
     zmq::message message;
     const auto ec = socket.receive(message);
@@ -156,7 +156,7 @@ code message::receive(zmq::socket& socket)
     //-------------------------------------------------------------------------
 
     // Query command (returned to caller).
-    command_ = message.dequeue_text();
+    const auto command = message.dequeue_data();
 
     // Arbitrary caller data (returned to caller for correlation).
     if (!message.dequeue(id_))
@@ -165,7 +165,10 @@ code message::receive(zmq::socket& socket)
     // Serialized query.
     data_ = message.dequeue_data();
 
-    return error::success;
+    // The command is looked up in its frame and then decoded for the reply.
+    const auto ec = validate(command, data_.size());
+    command_.assign(command.begin(), command.end());
+    return ec;
 }
 
 code message::send(zmq::socket& socket) const
@@ -29,14 +29,17 @@ namespace server {
 subscription::subscription(const subscription& other)
   : route(other),
     id_(other.id_),
+    status_(other.status_),
     updated_(other.updated_.load()),
     sequence_(other.sequence_.load())
 {
 }
 
-subscription::subscription(const route& return_route, uint32_t id, time_t now)
+subscription::subscription(const route& return_route, uint32_t id, time_t now,
+    bool status)
   : route(return_route),
     id_(id),
+    status_(status),
     updated_(now),
     sequence_(0)
 {
@@ -47,6 +50,11 @@ uint32_t subscription::id() const
     return id_;
 }
 
+bool subscription::status() const
+{
+    return status_;
+}
+
 time_t subscription::updated() const
 {
     return updated_;
@@ -99,6 +107,7 @@ void swap(subscription& left, subscription& right)
     // Must be unqualified (no std namespace).
     swap(static_cast<route&>(left), static_cast<route&>(right));
     swap(left.id_, right.id_);
+    swap(left.status_, right.status_);
 
     // Swapping the atomics in assignment operator does not require atomicity.
     left.updated_ = right.updated_.exchange(left.updated_);
@@ -717,6 +717,41 @@ options_metadata parser::load_settings()
         value<bool>(&configured.server.transaction_service_enabled),
         "Enable the transaction publishing service, defaults to false."
     )
+    (
+        "server.header_cache_enabled",
+        value<bool>(&configured.server.header_cache_enabled),
+        "Maintain confirmed headers in memory for header queries, defaults to true."
+    )
+    (
+        "server.filter_cache_limit",
+        value<uint32_t>(&configured.server.filter_cache_limit),
+        "The number of most recent compact filters maintained in memory, defaults to 2016 (0 disables)."
+    )
+    (
+        "server.merkle_cache_limit",
+        value<uint32_t>(&configured.server.merkle_cache_limit),
+        "The number of block merkle trees maintained in memory, defaults to 144 (0 disables)."
+    )
+    (
+        "server.balance_cache_limit",
+        value<uint32_t>(&configured.server.balance_cache_limit),
+        "The maximum number of payment keys with balances maintained in memory, defaults to 10000 (0 disables)."
+    )
+    (
+        "server.history_cache_bytes",
+        value<uint32_t>(&configured.server.history_cache_bytes),
+        "The memory budget for histories of frequently queried payment keys, defaults to 67108864 (0 disables)."
+    )
+    (
+        "server.reorg_journal_depth",
+        value<uint32_t>(&configured.server.reorg_journal_depth),
+        "The number of blocks below the top for which reorganized history is journaled for delta queries, defaults to 100 (0 disables)."
+    )
+    (
+        "server.query_compression_threshold",
+        value<uint32_t>(&configured.server.query_compression_threshold),
+        "The response size above which deflate suffixed queries are compressed, defaults to 4096 (0 disables)."
+    )
     (
         "server.client_address",
         value<config::authority::list>(&configured.server.client_addresses),
@@ -774,6 +809,26 @@ options_metadata parser::load_settings()
         value<bool>(&configured.server.websockets_enabled),
         "Enable websocket endpoints, defaults to true."
     )
+    (
+        "websockets.compression_level",
+        value<uint16_t>(&configured.server.websockets_compression_level),
+        "The deflate level (1-9) of block and transaction notifications, defaults to 6 (0 disables compression)."
+    )
+    (
+        "websockets.queue_limit",
+        value<uint32_t>(&configured.server.websockets_queue_limit),
+        "The maximum bytes of notifications queued to a websocket client and not yet passed to its connection, defaults to 16777216 (0 disables limit)."
+    )
+    (
+        "websockets.disconnect_slow",
+        value<bool>(&configured.server.websockets_disconnect_slow),
+        "Disconnect a websocket client that exceeds the queue limit, defaults to false (drops notifications)."
+    )
+    (
+        "websockets.threads",
+        value<uint16_t>(&configured.server.websockets_threads),
+        "The number of threads rendering query responses per websocket query endpoint, defaults to 1 (0 renders on the websocket thread)."
+    )
     (
         "websockets.root",
         value<path>(&configured.protocol.web_root),
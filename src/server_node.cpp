@@ -18,8 +18,10 @@
  */
 #include <bitcoin/server/server_node.hpp>
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <utility>
 #include <bitcoin/node.hpp>
@@ -36,9 +38,20 @@ using namespace bc::protocol;
 using namespace bc::system;
 using namespace bc::system::chain;
 
+// Headers are loaded with this many store reads outstanding.
+static constexpr size_t header_batch_size = 100;
+
 server_node::server_node(const configuration& configuration)
   : full_node(configuration),
     configuration_(configuration),
+    loading_headers_(false),
+    filters_(configuration.server.filter_cache_limit),
+    merkle_trees_(configuration.server.merkle_cache_limit),
+    balances_(configuration.server.balance_cache_limit),
+    reorganizations_(configuration.server.reorg_journal_depth),
+    histories_(configuration.server.history_cache_bytes),
+    submissions_(std::bind(&server_node::organize_submission,
+        this, _1, _2)),
     authenticator_(*this),
     secure_query_service_(authenticator_, *this, true),
     public_query_service_(authenticator_, *this, false),
@@ -85,6 +98,181 @@ const bc::server::settings& server_node::server_settings() const
     return configuration_.server;
 }
 
+const header_cache& server_node::headers() const
+{
+    return headers_;
+}
+
+bool server_node::headers_loaded() const
+{
+    return configuration_.server.header_cache_enabled && !loading_headers_;
+}
+
+const filter_cache& server_node::filters() const
+{
+    return filters_;
+}
+
+merkle_cache& server_node::merkle_trees()
+{
+    return merkle_trees_;
+}
+
+history_cache& server_node::histories()
+{
+    return histories_;
+}
+
+const reorg_journal& server_node::reorganizations() const
+{
+    return reorganizations_;
+}
+
+balance_cache& server_node::balances()
+{
+    return balances_;
+}
+
+submission_queue& server_node::submissions()
+{
+    return submissions_;
+}
+
+session_socket::metrics::list server_node::websocket_metrics() const
+{
+    const auto& settings = configuration_.server;
+    const auto secure = settings.zeromq_server_private_key;
+    const auto insecure = !settings.secure_only;
+    session_socket::metrics::list result;
+
+    if (!settings.websockets_enabled)
+        return result;
+
+    if (settings.block_service_enabled)
+    {
+        if (secure)
+            result.push_back(secure_block_websockets_.get_metrics());
+
+        if (insecure)
+            result.push_back(public_block_websockets_.get_metrics());
+    }
+
+    if (settings.transaction_service_enabled)
+    {
+        if (secure)
+            result.push_back(secure_transaction_websockets_.get_metrics());
+
+        if (insecure)
+            result.push_back(public_transaction_websockets_.get_metrics());
+    }
+
+    return result;
+}
+
+// private
+void server_node::organize_submission(transaction_const_ptr tx,
+    submission_queue::result_handler handler)
+{
+    chain().organize(tx, handler);
+}
+
+// The full history of an admissible key is read so that it can be cached.
+void server_node::fetch_history(const hash_digest& key, size_t from_height,
+    history_handler handler)
+{
+    static constexpr size_t default_limit = 0;
+    static constexpr size_t default_from_height = 0;
+
+    payment_record::list payments;
+    if (histories_.get(payments, key, from_height))
+    {
+        handler(error::success, payments);
+        return;
+    }
+
+    if (!histories_.admissible(key))
+    {
+        chain().fetch_history(key, default_limit, from_height, handler);
+        return;
+    }
+
+    // The sequence guards the population against concurrent reorganization
+    // and pool announcements.
+    const auto sequence = histories_.sequence();
+
+    chain().fetch_history(key, default_limit, default_from_height,
+        std::bind(&server_node::handle_history,
+            this, _1, _2, key, from_height, sequence, handler));
+}
+
+void server_node::handle_history(const code& ec,
+    const payment_record::list& payments, const hash_digest& key,
+    size_t from_height, size_t sequence, history_handler handler)
+{
+    if (ec)
+    {
+        handler(ec, {});
+        return;
+    }
+
+    histories_.put(key, payments, sequence);
+
+    if (from_height == 0)
+    {
+        handler(error::success, payments);
+        return;
+    }
+
+    // Unconfirmed records have a height of max_uint32.
+    payment_record::list filtered;
+    std::copy_if(payments.begin(), payments.end(),
+        std::back_inserter(filtered),
+        [from_height](const payment_record& record)
+        {
+            return record.height() >= from_height;
+        });
+
+    handler(error::success, filtered);
+}
+
+void server_node::fetch_balance(const hash_digest& key,
+    balance_handler handler)
+{
+    static constexpr size_t default_from_height = 0;
+
+    balance_cache::balance balance;
+    if (balances_.get(balance, key))
+    {
+        handler(error::success, balance);
+        return;
+    }
+
+    // The sequence guards the population against concurrent reorganization
+    // and pool announcements.
+    const auto sequence = balances_.sequence();
+
+    fetch_history(key, default_from_height,
+        std::bind(&server_node::handle_balance_history,
+            this, _1, _2, key, sequence, handler));
+}
+
+void server_node::handle_balance_history(const code& ec,
+    const payment_record::list& payments, const hash_digest& key,
+    size_t sequence, balance_handler handler)
+{
+    if (ec)
+    {
+        handler(ec, {});
+        return;
+    }
+
+    balance_cache::pool_deltas pool;
+    balance_cache::point_values unspent;
+    const auto balance = balance_cache::compute(payments, pool, unspent);
+    balances_.put(key, balance, pool, unspent, sequence);
+    handler(error::success, balance);
+}
+
 // Run sequence.
 // ----------------------------------------------------------------------------
 
@@ -141,6 +329,17 @@ bool server_node::stop()
 // This must be called from the thread that constructed this class (see join).
 bool server_node::close()
 {
+    if (configuration_.server.history_cache_bytes != 0)
+        LOG_INFO(LOG_SERVER)
+            << "History cache hits (" << histories_.hits() << ") misses ("
+            << histories_.misses() << ") admissions ("
+            << histories_.admissions() << ") rejections ("
+            << histories_.rejections() << ").";
+
+    LOG_INFO(LOG_SERVER)
+        << "Transaction submissions (" << submissions_.submitted()
+        << ") in batches (" << submissions_.batches() << ").";
+
     // Invoke own stop to signal work suspension, then close node and join.
     return server_node::stop() && full_node::close();
 }
@@ -149,13 +348,13 @@ bool server_node::close()
 // ----------------------------------------------------------------------------
 
 code server_node::subscribe_key(const message& request,
-    hash_digest&& key, bool unsubscribe)
+    hash_digest&& key, bool unsubscribe, bool status)
 {
     return request.secure() ?
         secure_notification_worker_.subscribe_key(request,
-            std::move(key), unsubscribe) :
+            std::move(key), unsubscribe, status) :
         public_notification_worker_.subscribe_key(request,
-            std::move(key), unsubscribe);
+            std::move(key), unsubscribe, status);
 }
 
 code server_node::subscribe_stealth(const message& request,
@@ -174,11 +373,480 @@ code server_node::subscribe_stealth(const message& request,
 bool server_node::start_services()
 {
     return
+        start_header_cache() && start_filter_cache() &&
+        start_merkle_cache() && start_balance_cache() &&
+        start_reorg_journal() && start_history_cache() &&
         start_authenticator() && start_query_services() &&
         start_heartbeat_services() && start_block_services() &&
         start_transaction_services();
 }
 
+// Headers are loaded asynchronously, so the cache fills after startup. The
+// subscription precedes the load so that no reorganization is missed.
+bool server_node::start_header_cache()
+{
+    if (!configuration_.server.header_cache_enabled)
+        return true;
+
+    subscribe_blocks(
+        std::bind(&server_node::handle_headers,
+            this, _1, _2, _3, _4));
+
+    loading_headers_ = true;
+    load_headers(0);
+    return true;
+}
+
+bool server_node::handle_headers(const code& ec, size_t fork_height,
+    block_const_ptr_list_const_ptr incoming, block_const_ptr_list_const_ptr)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure handling new block for header cache: "
+            << ec.message();
+
+        // Don't let a failure here prevent future notifications.
+        return true;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!incoming || incoming->empty())
+        return true;
+
+    // A fork above the cached top is read from the store (which includes the
+    // incoming blocks), unless a load is already under way.
+    if (!headers_.reorganize(fork_height, *incoming) &&
+        !loading_headers_.exchange(true))
+        load_headers(headers_.size());
+
+    return true;
+}
+
+// Headers are read in height order, a batch at a time, behind the query load.
+void server_node::load_headers(size_t start)
+{
+    const auto batch = std::make_shared<header_batch>();
+    batch->start = start;
+    batch->pending = header_batch_size;
+    batch->codes.resize(header_batch_size);
+    batch->headers.resize(header_batch_size);
+
+    for (size_t index = 0; index < header_batch_size; ++index)
+        chain().fetch_block_header(start + index,
+            std::bind(&server_node::handle_header,
+                this, _1, _2, index, batch));
+}
+
+void server_node::handle_header(const code& ec, header_const_ptr header,
+    size_t index, header_batch_ptr batch)
+{
+    batch->codes[index] = ec;
+    batch->headers[index] = header;
+
+    if (--batch->pending == 0)
+        push_headers(batch);
+}
+
+// The load ends at the first height not found (above the confirmed top). A
+// read that does not link pops the cached top, since one of the two has been
+// superseded by a reorganization, so each retry resumes a header lower until
+// the cache and the store agree.
+void server_node::push_headers(header_batch_ptr batch)
+{
+    if (stopped())
+    {
+        loading_headers_ = false;
+        return;
+    }
+
+    for (size_t index = 0; index < batch->headers.size(); ++index)
+    {
+        const auto& ec = batch->codes[index];
+        const auto height = batch->start + index;
+
+        if (ec == error::service_stopped)
+        {
+            loading_headers_ = false;
+            return;
+        }
+
+        if (ec == error::not_found)
+        {
+            loading_headers_ = false;
+            LOG_INFO(LOG_SERVER)
+                << "Cached (" << headers_.size() << ") confirmed headers.";
+            return;
+        }
+
+        if (ec)
+        {
+            loading_headers_ = false;
+            LOG_WARNING(LOG_SERVER)
+                << "Failure loading header for header cache: "
+                << ec.message();
+            return;
+        }
+
+        // The pop is skipped if a reorganization has moved the cached top.
+        if (!headers_.push(height, *batch->headers[index]))
+        {
+            headers_.pop(height - 1);
+            break;
+        }
+    }
+
+    load_headers(headers_.size());
+}
+
+// Filters are loaded asynchronously, so the cache fills after startup.
+bool server_node::start_filter_cache()
+{
+    if (configuration_.server.filter_cache_limit == 0)
+        return true;
+
+    size_t top;
+    if (!chain().get_top_height(top, false))
+    {
+        LOG_ERROR(LOG_SERVER)
+            << "Failed to initialize filter cache.";
+        return false;
+    }
+
+    size_t start;
+    const auto generation = filters_.reorganize(start, top, top);
+
+    subscribe_blocks(
+        std::bind(&server_node::handle_filters,
+            this, _1, _2, _3, _4));
+
+    load_filters(generation, start, top);
+    return true;
+}
+
+bool server_node::handle_filters(const code& ec, size_t fork_height,
+    block_const_ptr_list_const_ptr incoming, block_const_ptr_list_const_ptr)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure handling new block for filter cache: "
+            << ec.message();
+
+        // Don't let a failure here prevent future notifications.
+        return true;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!incoming || incoming->empty())
+        return true;
+
+    size_t start;
+    const auto top = fork_height + incoming->size();
+    const auto generation = filters_.reorganize(start, fork_height, top);
+    load_filters(generation, start, top);
+    return true;
+}
+
+// The filter headers of the range are read first, to chain each header.
+void server_node::load_filters(size_t generation, size_t start, size_t stop)
+{
+    if (start > stop)
+        return;
+
+    chain().fetch_compact_filter_headers(filter_cache::filter_type, start,
+        stop, std::bind(&server_node::handle_filter_headers,
+            this, _1, _2, generation, start));
+}
+
+void server_node::handle_filter_headers(const code& ec,
+    compact_filter_headers_ptr headers, size_t generation, size_t start)
+{
+    if (stopped() || ec == error::service_stopped)
+        return;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure loading filter headers for filter cache: "
+            << ec.message();
+        return;
+    }
+
+    // BIP157: header = double_sha256(filter_hash || previous_header).
+    auto previous = headers->previous_filter_header();
+    const auto chained = std::make_shared<hash_list>();
+    chained->reserve(headers->filter_hashes().size());
+
+    for (const auto& filter_hash: headers->filter_hashes())
+    {
+        previous = bitcoin_hash(build_chunk({ filter_hash, previous }));
+        chained->push_back(previous);
+    }
+
+    load_filter(generation, start, chained, start);
+}
+
+// Filters are read in height order, one at a time, behind the query load.
+void server_node::load_filter(size_t generation, size_t height,
+    std::shared_ptr<const hash_list> headers, size_t start)
+{
+    if (height - start >= headers->size())
+        return;
+
+    chain().fetch_compact_filter(filter_cache::filter_type, height,
+        std::bind(&server_node::handle_filter,
+            this, _1, _2, _3, generation, headers, start));
+}
+
+// Loading stops once the window is superseded by a reorganization.
+void server_node::handle_filter(const code& ec, compact_filter_ptr filter,
+    size_t height, size_t generation, std::shared_ptr<const hash_list> headers,
+    size_t start)
+{
+    if (stopped() || ec == error::service_stopped)
+        return;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure loading filter for filter cache: "
+            << ec.message();
+        return;
+    }
+
+    if (filters_.push(generation, height, (*headers)[height - start],
+        *filter))
+        load_filter(generation, height + 1, headers, start);
+}
+
+// Trees are computed from announced blocks and upon query, so nothing is read
+// at startup.
+bool server_node::start_merkle_cache()
+{
+    if (configuration_.server.merkle_cache_limit == 0)
+        return true;
+
+    subscribe_blocks(
+        std::bind(&server_node::handle_merkle_trees,
+            this, _1, _2, _3, _4));
+
+    return true;
+}
+
+bool server_node::handle_merkle_trees(const code& ec, size_t fork_height,
+    block_const_ptr_list_const_ptr incoming, block_const_ptr_list_const_ptr)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure handling new block for merkle cache: "
+            << ec.message();
+
+        // Don't let a failure here prevent future notifications.
+        return true;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!incoming || incoming->empty())
+        return true;
+
+    merkle_trees_.reorganize(fork_height, *incoming);
+    return true;
+}
+
+// Balances are populated upon query, so only the top is read at startup.
+bool server_node::start_balance_cache()
+{
+    if (configuration_.server.balance_cache_limit == 0)
+        return true;
+
+    if (!balances_.initialize(chain()))
+    {
+        LOG_ERROR(LOG_SERVER)
+            << "Failed to initialize balance cache.";
+        return false;
+    }
+
+    subscribe_blocks(
+        std::bind(&server_node::handle_balances,
+            this, _1, _2, _3, _4));
+
+    subscribe_transactions(
+        std::bind(&server_node::handle_balance_transaction,
+            this, _1, _2));
+
+    return true;
+}
+
+bool server_node::handle_balances(const code& ec, size_t fork_height,
+    block_const_ptr_list_const_ptr incoming, block_const_ptr_list_const_ptr)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure handling new block for balance cache: "
+            << ec.message();
+
+        // Don't let a failure here prevent future notifications.
+        return true;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!incoming || incoming->empty())
+        return true;
+
+    balances_.reorganize(fork_height, *incoming);
+    return true;
+}
+
+bool server_node::handle_balance_transaction(const code& ec,
+    transaction_const_ptr tx)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure handling new transaction for balance cache: "
+            << ec.message();
+
+        // Don't let a failure here prevent future notifications.
+        return true;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!tx)
+        return true;
+
+    balances_.notify(*tx);
+    return true;
+}
+
+// Histories are populated upon query, so nothing is read at startup.
+bool server_node::start_history_cache()
+{
+    if (configuration_.server.history_cache_bytes == 0)
+        return true;
+
+    subscribe_blocks(
+        std::bind(&server_node::handle_histories,
+            this, _1, _2, _3, _4));
+
+    subscribe_transactions(
+        std::bind(&server_node::handle_history_transaction,
+            this, _1, _2));
+
+    return true;
+}
+
+bool server_node::handle_histories(const code& ec, size_t fork_height,
+    block_const_ptr_list_const_ptr incoming, block_const_ptr_list_const_ptr)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure handling new block for history cache: "
+            << ec.message();
+
+        // Don't let a failure here prevent future notifications.
+        return true;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!incoming || incoming->empty())
+        return true;
+
+    histories_.reorganize(fork_height, *incoming);
+    return true;
+}
+
+bool server_node::handle_history_transaction(const code& ec,
+    transaction_const_ptr tx)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure handling new transaction for history cache: "
+            << ec.message();
+
+        // Don't let a failure here prevent future notifications.
+        return true;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!tx)
+        return true;
+
+    histories_.notify(*tx);
+    return true;
+}
+
+// Without the journal all history deltas are full.
+bool server_node::start_reorg_journal()
+{
+    if (configuration_.server.reorg_journal_depth == 0)
+        return true;
+
+    if (!reorganizations_.initialize(chain()))
+    {
+        LOG_ERROR(LOG_SERVER)
+            << "Failed to initialize reorganization journal.";
+        return false;
+    }
+
+    subscribe_blocks(
+        std::bind(&server_node::handle_reorganizations,
+            this, _1, _2, _3, _4));
+
+    return true;
+}
+
+bool server_node::handle_reorganizations(const code& ec, size_t fork_height,
+    block_const_ptr_list_const_ptr incoming,
+    block_const_ptr_list_const_ptr outgoing)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_WARNING(LOG_SERVER)
+            << "Failure handling new block for reorganization journal: "
+            << ec.message();
+
+        // Don't let a failure here prevent future notifications.
+        return true;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!incoming || incoming->empty())
+        return true;
+
+    reorganizations_.reorganize(fork_height, *incoming,
+        outgoing ? *outgoing : block_const_ptr_list{});
+    return true;
+}
+
 bool server_node::start_authenticator()
 {
     const auto& settings = configuration_.server;
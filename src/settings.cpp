@@ -35,6 +35,13 @@ settings::settings()
     heartbeat_service_seconds(5),
     block_service_enabled(true),
     transaction_service_enabled(true),
+    header_cache_enabled(true),
+    filter_cache_limit(2016),
+    merkle_cache_limit(144),
+    balance_cache_limit(10000),
+    history_cache_bytes(67108864),
+    reorg_journal_depth(100),
+    query_compression_threshold(4096),
 
     // [websockets]
     websockets_secure_query_endpoint("tcp://*:9061"),
@@ -48,6 +55,10 @@ settings::settings()
     websockets_public_transaction_endpoint("tcp://*:9074"),
 
     websockets_enabled(true),
+    websockets_compression_level(6),
+    websockets_queue_limit(16777216),
+    websockets_disconnect_slow(false),
+    websockets_threads(1),
 
     // [zeromq]
     zeromq_secure_query_endpoint("tcp://*:9081"),
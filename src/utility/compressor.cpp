@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/utility/compressor.hpp>
+
+#include <string>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/define.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+using namespace boost::iostreams;
+
+static zlib_params to_params(int level)
+{
+    zlib_params params(level);
+    params.noheader = true;
+    return params;
+}
+
+compressor::compressor(int level)
+  : level_(level)
+{
+}
+
+// The filter chain is char based, so the sink is a string.
+bool compressor::deflate(data_chunk& out, const data_chunk& data) const
+{
+    std::string sink;
+
+    try
+    {
+        filtering_ostream stream;
+        stream.push(zlib_compressor(to_params(level_)));
+        stream.push(boost::iostreams::back_inserter(sink));
+        stream.write(reinterpret_cast<const char*>(data.data()),
+            data.size());
+
+        // Flushes the final block to the sink.
+        stream.reset();
+    }
+    catch (const zlib_error&)
+    {
+        return false;
+    }
+
+    out.assign(sink.begin(), sink.end());
+    return true;
+}
+
+bool compressor::inflate(data_chunk& out, const data_chunk& data) const
+{
+    std::string sink;
+
+    try
+    {
+        filtering_istream stream;
+        stream.push(zlib_decompressor(to_params(level_)));
+        stream.push(array_source(reinterpret_cast<const char*>(data.data()),
+            data.size()));
+        boost::iostreams::copy(stream, boost::iostreams::back_inserter(sink));
+    }
+    catch (const zlib_error&)
+    {
+        return false;
+    }
+
+    out.assign(sink.begin(), sink.end());
+    return true;
+}
+
+deflater::deflater(int level)
+  : level_(level), filter_(to_params(level))
+{
+}
+
+// Closing the stream resets the shared zlib stream for the next message.
+// A failed stream is replaced, since its state is not known to be reset.
+bool deflater::deflate(data_chunk& out, const data_chunk& data)
+{
+    std::string sink;
+
+    try
+    {
+        filtering_ostream stream;
+        stream.push(filter_);
+        stream.push(boost::iostreams::back_inserter(sink));
+        stream.write(reinterpret_cast<const char*>(data.data()),
+            data.size());
+
+        // Flushes the final block to the sink.
+        stream.reset();
+    }
+    catch (const zlib_error&)
+    {
+        filter_ = zlib_compressor(to_params(level_));
+        return false;
+    }
+
+    out.assign(sink.begin(), sink.end());
+    return true;
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,252 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/utility/filter_matcher.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+
+// BIP158 basic filter parameters.
+const uint8_t filter_matcher::golomb_bits = 19;
+const uint64_t filter_matcher::target_rate = 784931;
+
+// Reads bits most significant first, false if read past the end.
+class bit_reader
+{
+public:
+    bit_reader(data_chunk::const_iterator begin,
+        data_chunk::const_iterator end)
+      : it_(begin), end_(end), offset_(0)
+    {
+    }
+
+    bool read_bit(bool& out)
+    {
+        if (it_ == end_)
+            return false;
+
+        out = ((*it_ >> (7u - offset_)) & 1u) != 0;
+
+        if (++offset_ == 8u)
+        {
+            offset_ = 0;
+            ++it_;
+        }
+
+        return true;
+    }
+
+    bool read_bits(uint64_t& out, uint8_t count)
+    {
+        bool bit;
+        out = 0;
+
+        for (uint8_t index = 0; index < count; ++index)
+        {
+            if (!read_bit(bit))
+                return false;
+
+            out = (out << 1) | (bit ? 1u : 0u);
+        }
+
+        return true;
+    }
+
+    // Golomb-Rice: a unary quotient terminated by zero, then the remainder.
+    bool read_golomb(uint64_t& out, uint8_t bits)
+    {
+        bool bit;
+        uint64_t quotient = 0;
+
+        while (true)
+        {
+            if (!read_bit(bit))
+                return false;
+
+            if (!bit)
+                break;
+
+            ++quotient;
+        }
+
+        uint64_t remainder;
+        if (!read_bits(remainder, bits))
+            return false;
+
+        out = (quotient << bits) | remainder;
+        return true;
+    }
+
+private:
+    data_chunk::const_iterator it_;
+    const data_chunk::const_iterator end_;
+    uint8_t offset_;
+};
+
+template <typename Iterator>
+static uint64_t to_uint64(Iterator it, size_t size=sizeof(uint64_t))
+{
+    uint64_t out = 0;
+
+    for (size_t index = 0; index < size; ++index, ++it)
+        out |= static_cast<uint64_t>(*it) << (8u * index);
+
+    return out;
+}
+
+static inline uint64_t rotate(uint64_t value, uint8_t bits)
+{
+    return (value << bits) | (value >> (64u - bits));
+}
+
+static inline void sipround(uint64_t& v0, uint64_t& v1, uint64_t& v2,
+    uint64_t& v3)
+{
+    v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+    v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+}
+
+// The high 64 bits of the 128 bit product, portable to 32 bit compilers.
+static uint64_t multiply_high(uint64_t left, uint64_t right)
+{
+    const auto left_low = left & 0xffffffffu;
+    const auto left_high = left >> 32;
+    const auto right_low = right & 0xffffffffu;
+    const auto right_high = right >> 32;
+
+    const auto low_low = left_low * right_low;
+    const auto high_low = left_high * right_low;
+    const auto low_high = left_low * right_high;
+    const auto high_high = left_high * right_high;
+
+    const auto cross = (low_low >> 32) + (high_low & 0xffffffffu) + low_high;
+    return high_high + (high_low >> 32) + (cross >> 32);
+}
+
+filter_matcher::filter_matcher(data_stack&& elements)
+  : elements_(std::move(elements))
+{
+}
+
+// static
+uint64_t filter_matcher::siphash(uint64_t k0, uint64_t k1,
+    const data_chunk& data)
+{
+    uint64_t v0 = k0 ^ 0x736f6d6570736575;
+    uint64_t v1 = k1 ^ 0x646f72616e646f6d;
+    uint64_t v2 = k0 ^ 0x6c7967656e657261;
+    uint64_t v3 = k1 ^ 0x7465646279746573;
+
+    const auto size = data.size();
+    const auto words = size / sizeof(uint64_t);
+    auto it = data.begin();
+
+    for (size_t word = 0; word < words; ++word, it += sizeof(uint64_t))
+    {
+        const auto value = to_uint64(it);
+        v3 ^= value;
+        sipround(v0, v1, v2, v3);
+        sipround(v0, v1, v2, v3);
+        v0 ^= value;
+    }
+
+    const auto last = (static_cast<uint64_t>(size) << 56) |
+        to_uint64(it, size % sizeof(uint64_t));
+
+    v3 ^= last;
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// The key is the first 16 bytes of the block hash (internal byte order).
+filter_matcher::value_list filter_matcher::hashed_set(
+    const hash_digest& block_hash, uint64_t range) const
+{
+    const auto k0 = to_uint64(block_hash.begin());
+    const auto k1 = to_uint64(block_hash.begin() + sizeof(uint64_t));
+
+    value_list values;
+    values.reserve(elements_.size());
+
+    for (const auto& element: elements_)
+        values.push_back(multiply_high(siphash(k0, k1, element), range));
+
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+// Both sets are sorted, so they are merged in a single pass.
+bool filter_matcher::match(const hash_digest& block_hash,
+    const data_chunk& filter) const
+{
+    if (elements_.empty())
+        return false;
+
+    auto deserial = make_safe_deserializer(filter.begin(), filter.end());
+    const auto count = deserial.read_variable_little_endian();
+
+    // Each member is encoded in at least golomb_bits + 1 bits.
+    if (!deserial || count == 0 || count > filter.size() * 8u)
+        return false;
+
+    const auto targets = hashed_set(block_hash, count * target_rate);
+    bit_reader reader(filter.begin() + variable_uint_size(count),
+        filter.end());
+
+    auto target = targets.begin();
+    uint64_t value = 0;
+    uint64_t delta;
+
+    for (uint64_t index = 0; index < count; ++index)
+    {
+        if (!reader.read_golomb(delta, golomb_bits))
+            return false;
+
+        value += delta;
+
+        while (*target < value)
+            if (++target == targets.end())
+                return false;
+
+        if (*target == value)
+            return true;
+    }
+
+    return false;
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/utility/history_encoder.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+using namespace bc::system::chain;
+
+const uint8_t history_encoder::record_output = 0x01;
+const uint8_t history_encoder::record_unconfirmed = 0x02;
+
+data_chunk history_encoder::encode(const payment_record::list& payments,
+    size_t prefix)
+{
+    // Unconfirmed records have a height of max_uint32 so sort last.
+    std::vector<const payment_record*> records;
+    records.reserve(payments.size());
+
+    for (const auto& record: payments)
+        records.push_back(&record);
+
+    std::stable_sort(records.begin(), records.end(),
+        [](const payment_record* left, const payment_record* right)
+        {
+            return left->height() < right->height();
+        });
+
+    hash_list hashes;
+    std::unordered_map<hash_digest, size_t> ordinals;
+    std::vector<size_t> references;
+    references.reserve(records.size());
+
+    for (const auto record: records)
+    {
+        const auto it = ordinals.emplace(record->hash(), hashes.size());
+
+        if (it.second)
+            hashes.push_back(record->hash());
+
+        references.push_back(it.first->second);
+    }
+
+    // Sizing pass.
+    size_t previous = 0;
+    auto size = prefix + variable_uint_size(hashes.size()) +
+        hash_size * hashes.size() + variable_uint_size(records.size());
+
+    for (size_t position = 0; position < records.size(); ++position)
+    {
+        const auto& record = *records[position];
+        const auto unconfirmed = record.height() == max_uint32;
+
+        size += sizeof(uint8_t) + variable_uint_size(references[position]) +
+            variable_uint_size(record.index());
+
+        if (!unconfirmed)
+        {
+            size += variable_uint_size(record.height() - previous);
+            previous = record.height();
+        }
+
+        size += record.is_output() ? variable_uint_size(record.data()) :
+            sizeof(uint64_t);
+    }
+
+    data_chunk result(size);
+    auto serial = make_unsafe_serializer(result.begin() + prefix);
+    serial.write_variable_little_endian(hashes.size());
+
+    for (const auto& hash: hashes)
+        serial.write_hash(hash);
+
+    serial.write_variable_little_endian(records.size());
+    previous = 0;
+
+    for (size_t position = 0; position < records.size(); ++position)
+    {
+        const auto& record = *records[position];
+        const auto unconfirmed = record.height() == max_uint32;
+
+        serial.write_byte(static_cast<uint8_t>(
+            (record.is_output() ? record_output : 0) |
+            (unconfirmed ? record_unconfirmed : 0)));
+        serial.write_variable_little_endian(references[position]);
+        serial.write_variable_little_endian(record.index());
+
+        if (!unconfirmed)
+        {
+            serial.write_variable_little_endian(record.height() - previous);
+            previous = record.height();
+        }
+
+        if (record.is_output())
+            serial.write_variable_little_endian(record.data());
+        else
+            serial.write_8_bytes_little_endian(record.data());
+    }
+
+    return result;
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/utility/key_journal.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/utility/payment_key.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+using namespace bc::system::chain;
+
+key_journal::key_journal(size_t limit)
+  : limit_(limit), horizon_(0)
+{
+}
+
+void key_journal::record(const transaction& tx, size_t sequence)
+{
+    for (const auto& output: tx.outputs())
+        record(payment_key::to_key(output.script()), sequence);
+
+    // An input without a cached previous output may spend from any key, so
+    // all reads that precede it are invalidated.
+    for (const auto& input: tx.inputs())
+    {
+        const auto& prevout = input.previous_output().metadata.cache;
+
+        if (prevout.is_valid())
+            record(payment_key::to_key(prevout.script()), sequence);
+        else
+            horizon_ = std::max(horizon_, sequence);
+    }
+
+    while (announcements_.size() > limit_)
+    {
+        const auto& oldest = announcements_.front();
+        const auto it = latest_.find(oldest.first);
+
+        if (it != latest_.end() && it->second == oldest.second)
+            latest_.erase(it);
+
+        horizon_ = std::max(horizon_, oldest.second);
+        announcements_.pop_front();
+    }
+}
+
+bool key_journal::changed(const hash_digest& key, size_t sequence) const
+{
+    if (horizon_ > sequence)
+        return true;
+
+    const auto it = latest_.find(key);
+    return it != latest_.end() && it->second > sequence;
+}
+
+// private
+void key_journal::record(const hash_digest& key, size_t sequence)
+{
+    latest_[key] = sequence;
+    announcements_.emplace_back(key, sequence);
+}
+
+} // namespace server
+} // namespace libbitcoin
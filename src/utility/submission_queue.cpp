@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/utility/submission_queue.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace std::placeholders;
+using namespace bc::system;
+
+submission_queue::submission_queue(organizer organize)
+  : organize_(organize),
+    submitted_(0),
+    batches_(0),
+    organizing_(false),
+    calling_(false),
+    completed_(false),
+    index_(0)
+{
+}
+
+size_t submission_queue::submitted() const
+{
+    return submitted_;
+}
+
+size_t submission_queue::batches() const
+{
+    return batches_;
+}
+
+// The first submission to an idle queue starts the drain on its thread.
+void submission_queue::submit(transaction_const_ptr tx,
+    result_handler handler)
+{
+    ++submitted_;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    pending_.push_back({ tx, handler });
+    const auto start = !organizing_;
+    organizing_ = true;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (start)
+        drain();
+}
+
+// Take the next submission, the pending submissions form the next batch.
+bool submission_queue::next(submission& out)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (index_ == batch_.size())
+    {
+        batch_.clear();
+        index_ = 0;
+
+        if (pending_.empty())
+        {
+            organizing_ = false;
+            return false;
+        }
+
+        batch_.swap(pending_);
+        ++batches_;
+    }
+
+    out = std::move(batch_[index_++]);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The organizer is serial, so each submission awaits the previous. A
+// completion within the organize call is continued by this loop, otherwise
+// the completion handler resumes the drain on its own thread.
+void submission_queue::drain()
+{
+    submission item;
+
+    while (next(item))
+    {
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+        calling_ = true;
+        completed_ = false;
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        organize_(item.tx,
+            std::bind(&submission_queue::handle_organized,
+                this, _1, item.handler));
+
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+        calling_ = false;
+        const auto completed = completed_;
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
+
+        if (!completed)
+            return;
+    }
+}
+
+void submission_queue::handle_organized(const code& ec,
+    result_handler handler)
+{
+    handler(ec);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+    completed_ = true;
+    const auto resume = !calling_;
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (resume)
+        drain();
+}
+
+} // namespace server
+} // namespace libbitcoin
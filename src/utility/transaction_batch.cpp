@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/utility/transaction_batch.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <bitcoin/system.hpp>
+#include <bitcoin/server/messages/message.hpp>
+#include <bitcoin/server/server_node.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::system;
+using namespace std::placeholders;
+
+static constexpr size_t code_size = sizeof(uint32_t);
+static constexpr auto canonical = system::message::version::level::canonical;
+
+const size_t transaction_batch::maximum_hashes = 100;
+
+// [ hash:32 ]... (1 to maximum_hashes)
+void transaction_batch::fetch(server_node& node, const message& request,
+    send_handler handler, bool require_confirmed, bool witness)
+{
+    const auto& data = request.data();
+    const auto count = data.size() / hash_size;
+
+    if (data.empty() || data.size() % hash_size != 0 ||
+        count > maximum_hashes)
+    {
+        handler(message(request, error::bad_stream));
+        return;
+    }
+
+    hash_list hashes;
+    hashes.reserve(count);
+    auto deserial = make_safe_deserializer(data.begin(), data.end());
+
+    for (size_t index = 0; index < count; ++index)
+        hashes.push_back(deserial.read_hash());
+
+    fetch(node, std::move(hashes), require_confirmed, witness,
+        std::bind(&transaction_batch::batch_fetched,
+            _1, _2, request, handler));
+}
+
+void transaction_batch::fetch(server_node& node, hash_list&& hashes,
+    bool require_confirmed, bool witness, batch_handler handler)
+{
+    if (hashes.empty())
+    {
+        handler({}, {}, {});
+        return;
+    }
+
+    std::make_shared<transaction_batch>(node, std::move(hashes),
+        require_confirmed, witness, handler)->start();
+}
+
+// The failure of an individual fetch does not fail the response.
+// [ code:4 ]
+// [[ code:4 ][ size:varint ][ tx... ]]... (one per requested hash)
+void transaction_batch::batch_fetched(const code_list& codes,
+    const transaction_list& transactions, const message& request,
+    send_handler handler)
+{
+    data_stack datas;
+    datas.reserve(transactions.size());
+    auto size = code_size;
+
+    for (size_t index = 0; index < transactions.size(); ++index)
+    {
+        datas.push_back(codes[index] ? data_chunk{} :
+            transactions[index]->to_data(canonical));
+
+        const auto length = datas.back().size();
+        size += code_size + variable_uint_size(length) + length;
+    }
+
+    data_chunk result(size);
+    auto serial = make_unsafe_serializer(result.begin());
+    serial.write_error_code(error::success);
+
+    for (size_t index = 0; index < datas.size(); ++index)
+    {
+        serial.write_error_code(codes[index]);
+        serial.write_variable_little_endian(datas[index].size());
+        serial.write_bytes(datas[index]);
+    }
+
+    handler(message(request, std::move(result)));
+}
+
+transaction_batch::transaction_batch(server_node& node, hash_list&& hashes,
+    bool require_confirmed, bool witness, batch_handler handler)
+  : node_(node),
+    hashes_(std::move(hashes)),
+    require_confirmed_(require_confirmed),
+    witness_(witness),
+    handler_(handler),
+    next_(0),
+    pending_(hashes_.size()),
+    codes_(hashes_.size()),
+    transactions_(hashes_.size())
+{
+}
+
+void transaction_batch::start()
+{
+    fetch(next_indexes());
+}
+
+// Call under lock (or before concurrency).
+// A long list (such as a history) is read in a window of maximum_hashes.
+transaction_batch::indexes transaction_batch::next_indexes()
+{
+    indexes out;
+    const auto completed = hashes_.size() - pending_;
+
+    while (next_ < hashes_.size() && next_ - completed < maximum_hashes)
+        out.push_back(next_++);
+
+    return out;
+}
+
+void transaction_batch::fetch(const indexes& values)
+{
+    const auto self = shared_from_this();
+
+    for (const auto index: values)
+        node_.chain().fetch_transaction(hashes_[index], require_confirmed_,
+            witness_, std::bind(&transaction_batch::handle_fetched,
+                self, _1, _2, index));
+}
+
+void transaction_batch::handle_fetched(const code& ec,
+    transaction_const_ptr tx, size_t index)
+{
+    indexes values;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    codes_[index] = ec;
+    transactions_[index] = tx;
+    const auto completed = (--pending_ == 0);
+    values = next_indexes();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // All writes are complete, so the results may be read without the lock.
+    if (completed)
+        handler_(codes_, transactions_, hashes_);
+    else
+        fetch(values);
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -18,9 +18,12 @@
  */
 #include <bitcoin/server/web/block_socket.hpp>
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <boost/property_tree/ptree.hpp>
 #include <bitcoin/protocol.hpp>
 #include <bitcoin/server/configuration.hpp>
 #include <bitcoin/server/define.hpp>
@@ -41,7 +44,7 @@ static constexpr auto poll_interval_milliseconds = 100u;
 
 block_socket::block_socket(zmq::context& context, server_node& node,
     bool secure)
-  : http::socket(context, node.protocol_settings(), secure),
+  : session_socket(context, node, secure, true),
     settings_(node.server_settings()),
     protocol_settings_(node.protocol_settings())
 {
@@ -108,9 +111,53 @@ void block_socket::work()
         LOG_ERROR(LOG_SERVER)
             << "Failed to stop " << security_ << " block websocket handler.";
 
+    if (dropped() > 0)
+        LOG_INFO(LOG_SERVER)
+            << "Dropped " << dropped() << " " << security_
+            << " block websocket notifications and disconnected "
+            << evicted() << " slow clients.";
+
     finished(sub_stop && websocket_stop);
 }
 
+// Filtered sessions are sent only the hash of each matching transaction.
+// The keys of the block are indexed once, and looked up by session filter.
+// [ sequence:2 ]
+// [ height:4 ]
+// [ tx_hash:32 ]
+void block_socket::publish_confirmations(const data_chunk& block_data,
+    uint32_t height, uint16_t sequence)
+{
+    const auto block = system::chain::block::factory(block_data, true);
+    const auto& txs = block.transactions();
+    key_index index;
+
+    for (size_t position = 0; position < txs.size(); ++position)
+        for (const auto& key: notification_worker::to_keys(txs[position]))
+            index[key].push_back(position);
+
+    const auto to_payload = [&](size_t position)
+    {
+        return build_chunk(
+        {
+            to_little_endian(sequence),
+            to_little_endian(height),
+            txs[position].hash()
+        });
+    };
+
+    const auto to_json = [&](size_t position)
+    {
+        boost::property_tree::ptree tree;
+        tree.put("sequence", sequence);
+        tree.put("height", height);
+        tree.put("confirmation", encode_hash(txs[position].hash()));
+        return http::to_json(tree);
+    };
+
+    publish(index, txs.size(), to_payload, to_json);
+}
+
 // Called by this thread's work() method.
 // Returns true to continue future notifications.
 bool block_socket::handle_block(zmq::socket& subscriber)
@@ -138,9 +185,26 @@ bool block_socket::handle_block(zmq::socket& subscriber)
     response.dequeue<uint32_t>(height);
     response.dequeue(block_data);
 
-    // Format and send transaction to websocket subscribers.
-    const auto block = system::chain::block::factory(block_data, true);
-    broadcast(http::to_json(block, height, sequence));
+    // [ sequence:2 ]
+    // [ height:4 ]
+    // [ block:... ]
+    // Binary sessions receive the notification as published by the service.
+    const auto payload = build_chunk(
+    {
+        to_little_endian(sequence),
+        to_little_endian(height),
+        block_data
+    });
+
+    // Format and send block to websocket subscribers.
+    publish(payload, [&]()
+    {
+        const auto block = system::chain::block::factory(block_data, true);
+        return http::to_json(block, height, sequence);
+    });
+
+    if (filtered())
+        publish_confirmations(block_data, height, sequence);
 
     LOG_VERBOSE(LOG_SERVER)
         << "Broadcasted " << security_ << " socket block ["
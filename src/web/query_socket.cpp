@@ -18,6 +18,10 @@
  */
 #include <bitcoin/server/web/query_socket.hpp>
 
+#include <cstdint>
+#include <sstream>
+#include <utility>
+#include <vector>
 #include <bitcoin/protocol.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/server_node.hpp>
@@ -36,11 +40,105 @@ using connection_ptr = http::connection_ptr;
 
 static constexpr auto poll_interval_milliseconds = 100u;
 
+// Queries answered here are sequenced apart from those of the base.
+static constexpr uint32_t pending_flag = 0x80000000;
+static constexpr auto canonical = message::version::level::canonical;
+
+// Data at least as deep as coinbase maturity is considered immutable.
+static constexpr auto immutable_depth = coinbase_maturity;
+
+static const auto cache_immutable = "public, max-age=31536000, immutable";
+static const auto cache_mutable = "no-cache";
+static const auto status_ok = "200 OK";
+static const auto status_not_modified = "304 Not Modified";
+static const auto status_bad_request = "400 Bad Request";
+static const auto status_not_found = "404 Not Found";
+
+// REST utilities.
+// ----------------------------------------------------------------------------
+
+static std::string to_reply(const std::string& status,
+    const std::string& etag, const std::string& cache,
+    const std::string& type, const std::string& body)
+{
+    std::ostringstream reply;
+    reply << "HTTP/1.1 " << status << "\r\n";
+
+    if (!etag.empty())
+        reply << "ETag: " << etag << "\r\n";
+
+    if (!cache.empty())
+        reply << "Cache-Control: " << cache << "\r\n";
+
+    if (!type.empty())
+        reply << "Content-Type: " << type << "\r\n";
+
+    // A not modified reply has no body and no content length.
+    if (status != status_not_modified)
+        reply << "Content-Length: " << body.size() << "\r\n";
+
+    reply << "\r\n" << body;
+    return reply.str();
+}
+
+static std::string to_reply(const std::string& status)
+{
+    return to_reply(status, {}, {}, {}, {});
+}
+
+// Header names are case insensitive.
+static std::string find_header(const http::http_request& request,
+    const std::string& name)
+{
+    for (const auto& header: request.headers)
+        if (boost::iequals(header.first, name))
+            return header.second;
+
+    return {};
+}
+
+// True if the strong tag is in the If-None-Match list (or it is "*").
+static bool is_match(const std::string& if_none_match, const std::string& etag)
+{
+    std::vector<std::string> tags;
+    boost::split(tags, if_none_match, boost::is_any_of(","));
+
+    for (auto& tag: tags)
+    {
+        boost::trim(tag);
+        if (tag == "*" || tag == etag)
+            return true;
+    }
+
+    return false;
+}
+
+static std::string to_etag(const std::string& identity,
+    const std::string& extension)
+{
+    return "\"" + identity + "." + extension + "\"";
+}
+
+// A JSON-RPC response is an HTTP reply, otherwise the JSON is a text frame.
+static std::string to_response(connection_ptr connection,
+    const std::string& json)
+{
+    if (!connection->json_rpc())
+        return json;
+
+    http::http_reply reply;
+    return reply.generate(http::protocol_status::ok, {}, json.size(),
+        false) + json;
+}
+
 query_socket::query_socket(zmq::context& context, server_node& node,
     bool secure)
-  : http::socket(context, node.protocol_settings(), secure),
+  : session_socket(context, node, secure, false),
+    node_(node),
     settings_(node.server_settings()),
-    protocol_settings_(node.protocol_settings())
+    protocol_settings_(node.protocol_settings()),
+    render_pool_("query_render", 0),
+    pending_sequence_(0)
 {
     // JSON to ZMQ request encoders.
     //-------------------------------------------------------------------------
@@ -118,96 +216,105 @@ query_socket::query_socket(zmq::context& context, server_node& node,
         return connection->write(response) == json_size;
     };
 
-    // JSON to ZMQ response decoders.
+    // ZMQ response to JSON renderers.
     // -------------------------------------------------------------------------
-    // These all run on the websocket thread, so can write on the
-    // connection directly.
-    const auto decode_height_raw = [decode_send](const data_chunk& data,
-        const uint32_t id, connection_ptr connection, bool rpc)
+    // These are thread safe, so are run by the render pool if enabled and
+    // otherwise by the decoders below.
+    const auto render_height_raw = [](const data_chunk& data,
+        const uint32_t id, bool rpc)
     {
         data_source istream(data);
         istream_reader source(istream);
         const auto height = source.read_4_bytes_little_endian();
-        const auto json = rpc ? http::rpc::to_json(height, id) : http::to_json(
-            height, id);
-        decode_send(connection, json);
+        return rpc ? http::rpc::to_json(height, id) : http::to_json(height,
+            id);
     };
 
-    const auto decode_transaction_raw = [&node, decode_send](
-        const data_chunk& data, const uint32_t id, connection_ptr connection,
-        bool rpc)
+    const auto render_transaction_raw = [&node](const data_chunk& data,
+        const uint32_t id, bool rpc)
     {
         const auto witness = chain::script::is_enabled(
             node.blockchain_settings().enabled_forks(), rule_fork::bip141_rule);
         const auto transaction = chain::transaction::factory(data, true,
             witness);
-        const auto json = rpc ? http::rpc::to_json(transaction, id) :
+        return rpc ? http::rpc::to_json(transaction, id) :
             http::to_json(transaction, id);
-        decode_send(connection, json);
     };
 
-    const auto decode_block_raw = [&node, decode_send](const data_chunk& data,
-        const uint32_t id, connection_ptr connection, bool rpc)
+    const auto render_block_raw = [&node](const data_chunk& data,
+        const uint32_t id, bool rpc)
     {
         const auto witness = chain::script::is_enabled(
             node.blockchain_settings().enabled_forks(), rule_fork::bip141_rule);
         const auto block = chain::block::factory(data, witness);
-        const auto json = rpc ? http::rpc::to_json(block, id) :
-            http::to_json(block, id);
-        decode_send(connection, json);
+        return rpc ? http::rpc::to_json(block, id) : http::to_json(block, id);
     };
 
-    const auto decode_block_header_raw = [decode_send](const data_chunk& data,
-        const uint32_t id, connection_ptr connection, bool rpc)
+    const auto render_block_header_raw = [](const data_chunk& data,
+        const uint32_t id, bool rpc)
     {
         const auto header = chain::header::factory(data, true);
-        const auto json = rpc ? http::rpc::to_json(header, id) :
-            http::to_json(header, id);
-        decode_send(connection, json);
+        return rpc ? http::rpc::to_json(header, id) : http::to_json(header,
+            id);
     };
 
-    const auto decode_block_hash_from_header_raw = [decode_send](
-        const data_chunk& data, uint32_t id, connection_ptr connection,
-        bool rpc)
+    const auto render_block_hash_from_header_raw = [](const data_chunk& data,
+        uint32_t id, bool rpc)
     {
         const auto header = chain::header::factory(data, true);
-        const auto json = rpc ? http::rpc::to_json(header.hash(), id) :
+        return rpc ? http::rpc::to_json(header.hash(), id) :
             http::to_json(header.hash(), id);
-        decode_send(connection, json);
     };
 
-// Defines both handler variants based on the raw method, one for
+// Defines both renderer variants based on the raw method, one for
 // native and one for rpc.
-#define BUILD_DECODER(name) \
-    const auto name = std::bind(name##_raw, _1, _2, _3, false); \
-    const auto name##_rpc = std::bind(name##_raw, _1, _2, _3, true)
+#define BUILD_RENDERER(name) \
+    const renderer name = std::bind(name##_raw, _1, _2, false); \
+    const renderer name##_rpc = std::bind(name##_raw, _1, _2, true)
+
+    BUILD_RENDERER(render_height);
+    BUILD_RENDERER(render_transaction);
+    BUILD_RENDERER(render_block);
+    BUILD_RENDERER(render_block_header);
+    BUILD_RENDERER(render_block_hash_from_header);
 
-    BUILD_DECODER(decode_height);
-    BUILD_DECODER(decode_transaction);
-    BUILD_DECODER(decode_block);
-    BUILD_DECODER(decode_block_header);
-    BUILD_DECODER(decode_block_hash_from_header);
+#undef BUILD_RENDERER
 
-#undef BUILD_DECODER
+    // JSON to ZMQ response decoders.
+    // -------------------------------------------------------------------------
+    // These all run on the websocket thread, so can write on the
+    // connection directly.
+    const auto decoder = [decode_send](renderer render)
+    {
+        return [decode_send, render](const data_chunk& data,
+            const uint32_t id, connection_ptr connection)
+        {
+            decode_send(connection, render(data, id));
+        };
+    };
 
-#define REGISTER_HANDLER(native, core, encoder, decoder) \
-    handlers_[core] = handlers{ native, encoder, decoder }; \
-    handlers_[native] = handlers{ native, encoder, decoder }; \
-    rpc_handlers_[core] = handlers{ native, encoder, decoder##_rpc }; \
-    rpc_handlers_[native] = handlers{ native, encoder, decoder##_rpc }
+#define REGISTER_HANDLER(native, core, encoder, render) \
+    handlers_[core] = handlers{ native, encoder, decoder(render) }; \
+    handlers_[native] = handlers{ native, encoder, decoder(render) }; \
+    rpc_handlers_[core] = handlers{ native, encoder, \
+        decoder(render##_rpc) }; \
+    rpc_handlers_[native] = handlers{ native, encoder, \
+        decoder(render##_rpc) }; \
+    renderers_[core] = renderers{ render, render##_rpc }; \
+    renderers_[native] = renderers{ render, render##_rpc }
 
     REGISTER_HANDLER("blockchain.fetch_last_height", "getblockcount",
-        encode_empty, decode_height);
+        encode_empty, render_height);
     REGISTER_HANDLER("transaction_pool.fetch_transaction", "getrawtransaction",
-        encode_hash, decode_transaction);
+        encode_hash, render_transaction);
     REGISTER_HANDLER("blockchain.fetch_block", "getblock",
-        encode_hash_or_height, decode_block);
+        encode_hash_or_height, render_block);
     REGISTER_HANDLER("blockchain.fetch_block_header", "getblockheader",
-        encode_hash_or_height, decode_block_header);
+        encode_hash_or_height, render_block_header);
     REGISTER_HANDLER("blockchain.fetch_block_header", "getblockhash",
-        encode_height, decode_block_hash_from_header);
+        encode_height, render_block_hash_from_header);
     REGISTER_HANDLER("blockchain.fetch_block_height", "getblockheight",
-        encode_hash, decode_height);
+        encode_hash, render_height);
 
 #undef REGISTER_HANDLER
 }
@@ -250,6 +357,9 @@ void query_socket::work()
         << "Bound " << security_ << " websocket query service to "
         << websocket_endpoint();
 
+    // Rendering threads are joined once the dealer is stopped.
+    render_pool_.spawn(settings_.websockets_threads);
+
     // Default page data can now be set since the base socket's manager has
     // been initialized.
     set_default_page_data(get_default_page_data(
@@ -281,6 +391,8 @@ void query_socket::work()
 
     const auto query_stop = query_receiver.stop();
     const auto dealer_stop = dealer.stop();
+    render_pool_.shutdown();
+    render_pool_.join();
     const auto websocket_stop = stop_websocket_handler();
 
     if (!query_stop)
@@ -335,10 +447,71 @@ bool query_socket::handle_query(zmq::socket& dealer)
         return true;
     }
 
-    socket::queue_response(sequence, data, command);
+    if (!handle_pending_query(sequence, data))
+        socket::queue_response(sequence, data, command);
+
+    return true;
+}
+
+// [ id:4 ]
+// [ code:4 ]
+// [ response:... ]
+// The response of a binary session query is framed without decoding, others
+// are rendered by the pool (in any order, as each carries its id).
+bool query_socket::handle_pending_query(uint32_t sequence, data_chunk& data)
+{
+    if ((sequence & pending_flag) == 0)
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    pending_mutex_.lock();
+
+    const auto it = pending_queries_.find(sequence);
+
+    if (it == pending_queries_.end())
+    {
+        pending_mutex_.unlock();
+        return false;
+    }
+
+    const auto query = it->second;
+    pending_queries_.erase(it);
+
+    pending_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (!query.render)
+    {
+        send_queued(query.connection, build_chunk(
+        {
+            to_little_endian(query.id),
+            data
+        }));
+
+        return true;
+    }
+
+    render_pool_.service().post(
+        std::bind(&query_socket::render,
+            this, query, std::move(data)));
+
     return true;
 }
 
+// This is run by the render pool, the write is queued to the websocket thread.
+// As with the base, an error is rendered in place of the response.
+void query_socket::render(const pending_query& query, const data_chunk& data)
+{
+    data_source istream(data);
+    istream_reader source(istream);
+    const auto ec = source.read_error_code();
+    const auto json = ec ? http::to_json(ec, query.id) :
+        query.render(source.read_bytes(), query.id);
+
+    send_queued(query.connection, to_response(query.connection, json));
+}
+
 const endpoint& query_socket::zeromq_endpoint() const
 {
     // The Websocket to zeromq backend internally always uses the
@@ -401,6 +574,304 @@ void query_socket::handle_websockets()
     }
 }
 
+// Queries (websocket thread).
+// ----------------------------------------------------------------------------
+
+// The base reports errors as JSON and decodes successful responses to JSON,
+// so binary session queries are forwarded here and their responses framed.
+// The queries of other sessions are forwarded here if rendering is pooled.
+void query_socket::notify_query_work(connection_ptr connection,
+    const std::string& method, uint32_t id, const std::string& parameters)
+{
+    const auto rpc = connection->json_rpc();
+    const auto binary = !rpc && framing(connection) == encoding::binary;
+    const auto& registered = rpc ? rpc_handlers_ : handlers_;
+    const auto handler = registered.find(method);
+
+    if (handler == registered.end() ||
+        (!binary && settings_.websockets_threads == 0))
+    {
+        session_socket::notify_query_work(connection, method, id, parameters);
+        return;
+    }
+
+    renderer render;
+
+    if (!binary)
+    {
+        const auto& variants = renderers_.at(method);
+        render = rpc ? variants.rpc : variants.native;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    pending_mutex_.lock();
+
+    const auto sequence = pending_flag | pending_sequence_++;
+    pending_queries_[sequence] = { connection, id, render };
+
+    pending_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    zmq::message request;
+    code ec(error::bad_stream);
+
+    if (handler->second.encode(request, handler->second.command, parameters,
+        sequence))
+        ec = service_->send(request);
+
+    if (!ec)
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    pending_mutex_.lock();
+    pending_queries_.erase(sequence);
+    pending_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (!binary)
+    {
+        connection->write(to_response(connection, http::to_json(ec, id)));
+        return;
+    }
+
+    send_binary(connection, build_chunk(
+    {
+        to_little_endian(id),
+        to_little_endian(static_cast<uint32_t>(ec.value()))
+    }));
+}
+
+// Pending queries of a closed connection are not answered.
+void query_socket::remove_connection(connection_ptr connection)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    pending_mutex_.lock();
+
+    for (auto it = pending_queries_.begin(); it != pending_queries_.end();)
+    {
+        if (it->second.connection == connection)
+            it = pending_queries_.erase(it);
+        else
+            ++it;
+    }
+
+    pending_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    session_socket::remove_connection(connection);
+}
+
+// REST (websocket thread).
+// ----------------------------------------------------------------------------
+
+// Routes are /<route>/<identity>[.<extension>], other requests are passed to
+// the base for file serving and JSON-RPC.
+bool query_socket::handle_http_request(connection_ptr connection,
+    const http::http_request& request)
+{
+    if (request.method != "GET")
+        return socket::handle_http_request(connection, request);
+
+    const auto path = request.uri.substr(0, request.uri.find('?'));
+    std::vector<std::string> tokens;
+    boost::split(tokens, path, boost::is_any_of("/"));
+
+    if (tokens.size() != 3 || !tokens.front().empty() ||
+        (tokens[1] != "block" && tokens[1] != "tx" && tokens[1] != "header"))
+        return socket::handle_http_request(connection, request);
+
+    const auto& route = tokens[1];
+    auto identity = tokens[2];
+    std::string extension = "json";
+    const auto dot = identity.rfind('.');
+
+    if (dot != std::string::npos)
+    {
+        extension = identity.substr(dot + 1);
+        identity.resize(dot);
+    }
+
+    rest_format format;
+
+    if (extension == "json")
+        format = rest_format::json;
+    else if (extension == "bin")
+        format = rest_format::binary;
+    else if (extension == "hex")
+        format = rest_format::hex;
+    else
+    {
+        connection->write(to_reply(status_bad_request));
+        return true;
+    }
+
+    const auto if_none_match = find_header(request, "If-None-Match");
+
+    if (route == "header")
+    {
+        uint32_t height;
+        if (!deserialize(height, identity, false))
+        {
+            connection->write(to_reply(status_bad_request));
+            return true;
+        }
+
+        get_header(connection, height, format, if_none_match);
+        return true;
+    }
+
+    hash_digest hash;
+    if (!decode_hash(hash, identity))
+    {
+        connection->write(to_reply(status_bad_request));
+        return true;
+    }
+
+    // A hash identified block may yet be reorganized out, so a match requires
+    // the query to determine the cache policy of the not modified reply.
+    if (route == "block")
+        get_block(connection, hash, format, if_none_match);
+    else
+        get_transaction(connection, hash, format, if_none_match);
+
+    return true;
+}
+
+// REST (chain threads).
+// ----------------------------------------------------------------------------
+// Handlers are invoked on chain threads, so replies are queued.
+
+void query_socket::get_block(connection_ptr connection,
+    const hash_digest& hash, rest_format format,
+    const std::string& if_none_match)
+{
+    const auto witness = chain::script::is_enabled(
+        node_.blockchain_settings().enabled_forks(), rule_fork::bip141_rule);
+
+    node_.chain().fetch_block(hash, witness,
+        [=](const code& ec, block_const_ptr block)
+        {
+            if (ec)
+            {
+                send_queued(connection, to_reply(status_not_found));
+                return;
+            }
+
+            // The block is immutable only once buried on the main chain.
+            node_.chain().fetch_block_height(hash,
+                [=](const code& ec, size_t height)
+                {
+                    const auto json = format == rest_format::json ?
+                        http::to_json(*block, 0) : std::string{};
+
+                    send_rest(connection, encode_hash(hash),
+                        !ec && is_immutable(height), block->to_data(canonical),
+                        json, format, if_none_match);
+                });
+        });
+}
+
+void query_socket::get_transaction(connection_ptr connection,
+    const hash_digest& hash, rest_format format,
+    const std::string& if_none_match)
+{
+    // The response is restricted to confirmed transactions.
+    const auto require_confirmed = true;
+    const auto witness = chain::script::is_enabled(
+        node_.blockchain_settings().enabled_forks(), rule_fork::bip141_rule);
+
+    node_.chain().fetch_transaction(hash, require_confirmed, witness,
+        [=](const code& ec, transaction_const_ptr tx, size_t height, size_t)
+        {
+            if (ec)
+            {
+                send_queued(connection, to_reply(status_not_found));
+                return;
+            }
+
+            const auto json = format == rest_format::json ?
+                http::to_json(*tx, 0) : std::string{};
+
+            send_rest(connection, encode_hash(hash), is_immutable(height),
+                tx->to_data(canonical), json, format, if_none_match);
+        });
+}
+
+// The height does not identify the header, so a match requires the query.
+void query_socket::get_header(connection_ptr connection, size_t height,
+    rest_format format, const std::string& if_none_match)
+{
+    node_.chain().fetch_block_header(height,
+        [=](const code& ec, header_const_ptr header)
+        {
+            if (ec)
+            {
+                send_queued(connection, to_reply(status_not_found));
+                return;
+            }
+
+            const auto json = format == rest_format::json ?
+                http::to_json(*header, 0) : std::string{};
+
+            send_rest(connection, encode_hash(header->hash()),
+                is_immutable(height), header->to_data(canonical), json,
+                format, if_none_match);
+        });
+}
+
+// The tag is the hash of the data, so is strong for any depth.
+void query_socket::send_rest(connection_ptr connection,
+    const std::string& identity, bool immutable, const data_chunk& data,
+    const std::string& json, rest_format format,
+    const std::string& if_none_match)
+{
+    std::string extension;
+    std::string type;
+    std::string body;
+
+    switch (format)
+    {
+        case rest_format::json:
+            extension = "json";
+            type = "application/json";
+            body = json;
+            break;
+        case rest_format::binary:
+            extension = "bin";
+            type = "application/octet-stream";
+            body.assign(data.begin(), data.end());
+            break;
+        case rest_format::hex:
+            extension = "hex";
+            type = "text/plain";
+            body = encode_base16(data);
+            break;
+    }
+
+    // Mutable data is tagged but must be revalidated by caches.
+    const auto etag = to_etag(identity, extension);
+    const auto cache = immutable ? cache_immutable : cache_mutable;
+
+    if (is_match(if_none_match, etag))
+    {
+        send_queued(connection, to_reply(status_not_modified, etag, cache,
+            {}, {}));
+        return;
+    }
+
+    send_queued(connection, to_reply(status_ok, etag, cache, type, body));
+}
+
+bool query_socket::is_immutable(size_t height) const
+{
+    size_t top;
+    return node_.chain().get_top_height(top, false) &&
+        top >= height && (top - height) >= immutable_depth;
+}
+
 bool query_socket::start_websocket_handler()
 {
     auto started = socket_started_.get_future();
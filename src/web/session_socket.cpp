@@ -0,0 +1,628 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/server/web/session_socket.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+#include <bitcoin/protocol.hpp>
+#include <bitcoin/server/define.hpp>
+#include <bitcoin/server/server_node.hpp>
+#include <bitcoin/server/settings.hpp>
+
+namespace libbitcoin {
+namespace server {
+
+using namespace bc::protocol;
+using namespace bc::system;
+using namespace bc::system::wallet;
+
+static const auto encoding_method = "session.encoding";
+static const auto encoding_json = "json";
+static const auto encoding_binary = "binary";
+static const auto subscribe_method = "subscribe.key";
+static const auto unsubscribe_method = "unsubscribe.key";
+static const auto compression_method = "session.compression";
+static const auto compression_deflate = "deflate";
+static const auto compression_none = "none";
+static constexpr uint16_t max_compression_level = 9;
+
+typedef std::shared_ptr<std::atomic<size_t>> counter_ptr;
+
+// Writes a payload shared by all recipients of a broadcast to one connection.
+// This is run on the websocket thread by the manager.
+template <typename Message>
+class session_sender
+  : public http::manager::task
+{
+public:
+    session_sender(http::connection_ptr connection,
+        std::shared_ptr<const Message> message, counter_ptr queued)
+      : connection_(connection), message_(message), queued_(queued)
+    {
+    }
+
+    // The write is not observable once accepted by the connection.
+    bool run() override
+    {
+        // The queue is released whether or not the write succeeds.
+        *queued_ -= message_->size();
+
+        if (!connection_ || connection_->closed())
+            return false;
+
+        return connection_->write(*message_) ==
+            static_cast<int32_t>(message_->size());
+    }
+
+private:
+    http::connection_ptr connection_;
+    std::shared_ptr<const Message> message_;
+    counter_ptr queued_;
+};
+
+// Closes a connection that is not consuming its notifications.
+// This is run on the websocket thread by the manager.
+class session_evictor
+  : public http::manager::task
+{
+public:
+    session_evictor(http::connection_ptr connection)
+      : connection_(connection)
+    {
+    }
+
+    bool run() override
+    {
+        if (connection_ && !connection_->closed())
+            connection_->close();
+
+        return true;
+    }
+
+private:
+    http::connection_ptr connection_;
+};
+
+// Raw chunk writes are not framed by the connection, so the websocket frame
+// header is prepended here with the binary opcode.
+static data_chunk to_binary_frame(const data_chunk& payload)
+{
+    return build_chunk(
+    {
+        http::websocket_frame::to_header(payload.size(),
+            http::websocket_op::binary),
+        payload
+    });
+}
+
+// A payment address filters on the hash of its output script, otherwise the
+// parameter is the base16 script hash (as with the zeromq subscribe.key).
+static bool to_key(hash_digest& out, const std::string& parameters)
+{
+    const payment_address address(parameters);
+
+    if (address)
+    {
+        out = sha256_hash(address.output_script().to_data(false));
+        return true;
+    }
+
+    data_chunk data;
+    if (!decode_base16(data, parameters) || data.size() != hash_size)
+        return false;
+
+    std::copy(data.begin(), data.end(), out.begin());
+    return true;
+}
+
+session_socket::session_socket(zmq::context& context, server_node& node,
+    bool secure, bool notifications)
+  : http::socket(context, node.protocol_settings(), secure),
+    filter_limit_(notifications ?
+        node.server_settings().subscription_limit : 0),
+    compression_(notifications &&
+        node.server_settings().websockets_compression_level > 0),
+    compressor_(std::min(node.server_settings().websockets_compression_level,
+        max_compression_level)),
+    queue_limit_(node.server_settings().websockets_queue_limit),
+    disconnect_slow_(node.server_settings().websockets_disconnect_slow),
+    dropped_(0),
+    evicted_(0)
+{
+}
+
+size_t session_socket::dropped() const
+{
+    return dropped_;
+}
+
+size_t session_socket::evicted() const
+{
+    return evicted_;
+}
+
+session_socket::metrics session_socket::get_metrics() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(session_mutex_);
+
+    const auto queued = std::accumulate(sessions_.begin(), sessions_.end(),
+        size_t(0), [](size_t total, const session_map::value_type& entry)
+        {
+            return total + entry.second.queued->load();
+        });
+
+    return
+    {
+        websocket_endpoint(),
+        sessions_.size(),
+        queued,
+        dropped_,
+        evicted_
+    };
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Session tracking (websocket thread).
+// ----------------------------------------------------------------------------
+
+void session_socket::add_connection(connection_ptr connection)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    session_mutex_.lock();
+    sessions_.emplace(connection, session
+    {
+        encoding::json,
+        false,
+        {},
+        std::make_shared<std::atomic<size_t>>(0),
+        std::make_shared<std::atomic<bool>>(false)
+    });
+    session_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    socket::add_connection(connection);
+}
+
+void session_socket::remove_connection(connection_ptr connection)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    session_mutex_.lock();
+    sessions_.erase(connection);
+    session_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    socket::remove_connection(connection);
+}
+
+void session_socket::notify_query_work(connection_ptr connection,
+    const std::string& method, uint32_t id, const std::string& parameters)
+{
+    const auto filter = filter_limit_ > 0 &&
+        (method == subscribe_method || method == unsubscribe_method);
+    const auto compress = compression_ && method == compression_method;
+
+    // JSON-RPC connections are not persistent so there is no session state.
+    if ((method != encoding_method && !filter && !compress) ||
+        connection->json_rpc())
+    {
+        socket::notify_query_work(connection, method, id, parameters);
+        return;
+    }
+
+    // The reply precedes the change so the client can always parse it.
+    const auto ec =
+        filter ? set_filter(connection, parameters,
+            method == unsubscribe_method) :
+        compress ? set_compression(connection, parameters) :
+        set_framing(connection, parameters);
+
+    connection->write(http::to_json(ec, id));
+}
+
+code session_socket::set_framing(connection_ptr connection,
+    const std::string& parameters)
+{
+    encoding framing;
+
+    if (parameters == encoding_json)
+        framing = encoding::json;
+    else if (parameters == encoding_binary)
+        framing = encoding::binary;
+    else
+        return error::bad_stream;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(session_mutex_);
+
+    const auto it = sessions_.find(connection);
+
+    if (it == sessions_.end())
+        return error::not_found;
+
+    it->second.framing = framing;
+    return error::success;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+code session_socket::set_filter(connection_ptr connection,
+    const std::string& parameters, bool unsubscribe)
+{
+    hash_digest key;
+    if (!to_key(key, parameters))
+        return error::bad_stream;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(session_mutex_);
+
+    const auto it = sessions_.find(connection);
+
+    if (it == sessions_.end())
+        return error::not_found;
+
+    auto& filter = it->second.filter;
+
+    if (unsubscribe)
+    {
+        filter.erase(key);
+        return error::success;
+    }
+
+    if (filter.size() >= filter_limit_ && filter.find(key) == filter.end())
+        return error::oversubscribed;
+
+    filter.insert(key);
+    return error::success;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+code session_socket::set_compression(connection_ptr connection,
+    const std::string& parameters)
+{
+    bool deflated;
+
+    if (parameters == compression_deflate)
+        deflated = true;
+    else if (parameters == compression_none)
+        deflated = false;
+    else
+        return error::bad_stream;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(session_mutex_);
+
+    const auto it = sessions_.find(connection);
+
+    if (it == sessions_.end())
+        return error::not_found;
+
+    it->second.deflated = deflated;
+    return error::success;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+session_socket::encoding session_socket::framing(
+    connection_ptr connection) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(session_mutex_);
+
+    const auto it = sessions_.find(connection);
+    return it == sessions_.end() ? encoding::json : it->second.framing;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Sending.
+// ----------------------------------------------------------------------------
+
+// Called off the websocket thread, so the write is queued to the manager.
+// This is not subject to the session queue limit.
+void session_socket::send_queued(connection_ptr connection, std::string&& data)
+{
+    const auto message = std::make_shared<const std::string>(std::move(data));
+    const auto queued = std::make_shared<std::atomic<size_t>>(
+        message->size());
+
+    manager_->execute(std::make_shared<session_sender<std::string>>(
+        connection, message, queued));
+}
+
+// Called off the websocket thread, so the write is queued to the manager.
+// This is not subject to the session queue limit.
+void session_socket::send_queued(connection_ptr connection,
+    data_chunk&& payload)
+{
+    const auto message = std::make_shared<const data_chunk>(
+        to_binary_frame(payload));
+    const auto queued = std::make_shared<std::atomic<size_t>>(
+        message->size());
+
+    manager_->execute(std::make_shared<session_sender<data_chunk>>(
+        connection, message, queued));
+}
+
+// Called on the websocket thread, so the connection is written directly.
+bool session_socket::send_binary(connection_ptr connection,
+    const data_chunk& payload) const
+{
+    if (!connection || connection->closed())
+        return false;
+
+    const auto frame = to_binary_frame(payload);
+
+    if (frame.size() > std::numeric_limits<int32_t>::max())
+    {
+        LOG_ERROR(LOG_SERVER_HTTP)
+            << "Skipping binary response of size " << frame.size();
+        return false;
+    }
+
+    return connection->write(frame) == static_cast<int32_t>(frame.size());
+}
+
+bool session_socket::filtered() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(session_mutex_);
+
+    return std::any_of(sessions_.begin(), sessions_.end(),
+        [](const session_map::value_type& entry)
+        {
+            return !entry.second.filter.empty();
+        });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void session_socket::publish(const data_chunk& payload, json_factory to_json)
+{
+    publish_if([](const session& value)
+    {
+        return value.filter.empty();
+    }, payload, to_json);
+}
+
+void session_socket::publish(const key_set& keys, const data_chunk& payload,
+    json_factory to_json)
+{
+    publish_if([&keys](const session& value)
+    {
+        return std::any_of(keys.begin(), keys.end(),
+            [&value](const hash_digest& key)
+            {
+                return value.filter.find(key) != value.filter.end();
+            });
+    }, payload, to_json);
+}
+
+// static
+// The session state required to notify it, copied under the session lock.
+session_socket::recipient session_socket::to_recipient(
+    const session_map::value_type& entry)
+{
+    return
+    {
+        entry.first,
+        entry.second.framing,
+        entry.second.deflated,
+        entry.second.queued,
+        entry.second.evicting
+    };
+}
+
+// A message that would exceed the session's queue limit is dropped, and if so
+// configured the session is closed (once) on the websocket thread.
+template <typename Message>
+void session_socket::enqueue(const recipient& target,
+    std::shared_ptr<const Message> message)
+{
+    const auto size = message->size();
+    const auto queued = (*target.queued += size);
+
+    if (queue_limit_ == 0 || queued <= queue_limit_)
+    {
+        manager_->execute(std::make_shared<session_sender<Message>>(
+            target.connection, message, target.queued));
+        return;
+    }
+
+    *target.queued -= size;
+    const auto dropped = ++dropped_;
+
+    LOG_DEBUG(LOG_SERVER_HTTP)
+        << "Dropped " << security_ << " websocket notification of " << size
+        << " bytes (" << dropped << " total).";
+
+    if (disconnect_slow_ && !target.evicting->exchange(true))
+    {
+        ++evicted_;
+        LOG_WARNING(LOG_SERVER_HTTP)
+            << "Disconnecting slow " << security_ << " websocket client with "
+            << queued - size << " bytes queued.";
+
+        manager_->execute(std::make_shared<session_evictor>(
+            target.connection));
+    }
+}
+
+// Called off the websocket thread, so writes are queued to the manager.
+// Recipients are selected under the lock and rendering is performed outside
+// of it, so that session changes are not blocked by encoding.
+void session_socket::publish_if(session_predicate predicate,
+    const data_chunk& payload, json_factory to_json)
+{
+    recipient::list targets;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    session_mutex_.lock_shared();
+
+    for (const auto& entry: sessions_)
+        if (predicate(entry.second))
+            targets.push_back(to_recipient(entry));
+
+    session_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(targets, payload, to_json);
+}
+
+// Called off the websocket thread, so writes are queued to the manager.
+// Each session's filter is looked up in the index, collecting the ordinals of
+// its matched items, and the recipients of each item are then sent its
+// message. The lookup is bounded by the sum of the filter sizes.
+void session_socket::publish(const key_index& index, size_t items,
+    item_payload_factory to_payload, item_json_factory to_json)
+{
+    std::vector<recipient::list> targets(items);
+    std::vector<size_t> matches;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    session_mutex_.lock_shared();
+
+    for (const auto& entry: sessions_)
+    {
+        const auto& filter = entry.second.filter;
+
+        if (filter.empty())
+            continue;
+
+        matches.clear();
+
+        for (const auto& key: filter)
+        {
+            const auto it = index.find(key);
+
+            if (it != index.end())
+                matches.insert(matches.end(), it->second.begin(),
+                    it->second.end());
+        }
+
+        std::sort(matches.begin(), matches.end());
+        matches.erase(std::unique(matches.begin(), matches.end()),
+            matches.end());
+
+        for (const auto item: matches)
+            targets[item].push_back(to_recipient(entry));
+    }
+
+    session_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (size_t item = 0; item < items; ++item)
+        if (!targets[item].empty())
+            send(targets[item], to_payload(item),
+                std::bind(to_json, item));
+}
+
+// Each encoding is framed (and compressed) once and shared by all recipients
+// that selected it, so the cost does not scale with the recipient count.
+void session_socket::send(const recipient::list& targets,
+    const data_chunk& payload, json_factory to_json)
+{
+    std::shared_ptr<const std::string> json;
+    std::shared_ptr<const data_chunk> frame;
+    std::shared_ptr<const data_chunk> deflated_json;
+    std::shared_ptr<const data_chunk> deflated_frame;
+    auto deflated_json_failed = false;
+    auto deflated_frame_failed = false;
+
+    const auto get_json = [&]()
+    {
+        if (!json)
+            json = std::make_shared<const std::string>(to_json());
+
+        return json;
+    };
+
+    const auto get_frame = [&]()
+    {
+        if (!frame)
+            frame = std::make_shared<const data_chunk>(
+                to_binary_frame(payload));
+
+        return frame;
+    };
+
+    // A failure is recorded so that compression is attempted once per
+    // encoding, and its sessions fall back to the uncompressed message.
+    const auto deflate = [this](std::shared_ptr<const data_chunk>& deflated,
+        bool& failed, const data_chunk& data)
+    {
+        if (deflated || failed)
+            return;
+
+        data_chunk out;
+        if (!compressor_.deflate(out, data))
+        {
+            failed = true;
+            LOG_ERROR(LOG_SERVER_HTTP)
+                << "Failure compressing notification of size "
+                << data.size() << ", sending uncompressed.";
+            return;
+        }
+
+        deflated = std::make_shared<const data_chunk>(to_binary_frame(out));
+    };
+
+    for (const auto& target: targets)
+    {
+        if (target.framing == encoding::binary)
+        {
+            if (target.deflated)
+                deflate(deflated_frame, deflated_frame_failed, payload);
+
+            if (deflated_frame && target.deflated)
+                enqueue(target, deflated_frame);
+            else
+                enqueue(target, get_frame());
+        }
+        else
+        {
+            if (target.deflated)
+                deflate(deflated_json, deflated_json_failed,
+                    to_chunk(*get_json()));
+
+            if (deflated_json && target.deflated)
+                enqueue(target, deflated_json);
+            else
+                enqueue(target, get_json());
+        }
+    }
+}
+
+} // namespace server
+} // namespace libbitcoin
@@ -39,7 +39,7 @@ static constexpr auto poll_interval_milliseconds = 100u;
 
 transaction_socket::transaction_socket(zmq::context& context,
     server_node& node, bool secure)
-  : http::socket(context, node.protocol_settings(), secure),
+  : session_socket(context, node, secure, true),
     settings_(node.server_settings()),
     protocol_settings_(node.protocol_settings())
 {
@@ -108,6 +108,12 @@ void transaction_socket::work()
             << "Failed to stop " << security_
             << " transaction websocket handler.";
 
+    if (dropped() > 0)
+        LOG_INFO(LOG_SERVER)
+            << "Dropped " << dropped() << " " << security_
+            << " transaction websocket notifications and disconnected "
+            << evicted() << " slow clients.";
+
     finished(sub_stop && websocket_stop);
 }
 
@@ -146,7 +152,26 @@ bool transaction_socket::handle_transaction(zmq::socket& subscriber)
         return true;
     }
 
-    broadcast(http::to_json(tx, sequence));
+    // [ sequence:2 ]
+    // [ tx:... ]
+    // Binary sessions receive the notification as published by the service.
+    const auto payload = build_chunk(
+    {
+        to_little_endian(sequence),
+        transaction_data
+    });
+
+    const auto to_json = [&]()
+    {
+        return http::to_json(tx, sequence);
+    };
+
+    // Format and send transaction to websocket subscribers.
+    publish(payload, to_json);
+
+    // Keys are only computed if some session is filtering.
+    if (filtered())
+        publish(notification_worker::to_keys(tx), payload, to_json);
 
     LOG_VERBOSE(LOG_SERVER)
         << "Broadcasted " << security_ << " socket tx ["
@@ -26,6 +26,7 @@
 #include <string>
 #include <utility>
 #include <bitcoin/protocol.hpp>
+#include <bitcoin/server/caches/balance_cache.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/messages/message.hpp>
 #include <bitcoin/server/messages/route.hpp>
@@ -147,6 +148,35 @@ bool notification_worker::send(zmq::socket& dealer,
     }));
     ///////////////////////////////////////////////////////////////////////////
 
+    return send(dealer, reply);
+}
+
+bool notification_worker::send(zmq::socket& dealer,
+    const subscription& routing, const std::string& command,
+    const code& status, size_t height, const hash_digest& tx_hash,
+    const hash_digest& key_status)
+{
+    // [ code:4 ]
+    // [ sequence:2 ]
+    // [ height:4 ]
+    // [ tx hash:32 ]
+    // [ key status:32 ]
+    ///////////////////////////////////////////////////////////////////////////
+    message reply(routing, command, build_chunk(
+    {
+        message::to_bytes(status),
+        to_little_endian(routing.sequence()),
+        to_little_endian(static_cast<uint32_t>(height)),
+        tx_hash,
+        key_status
+    }));
+    ///////////////////////////////////////////////////////////////////////////
+
+    return send(dealer, reply);
+}
+
+bool notification_worker::send(zmq::socket& dealer, const message& reply)
+{
     const auto ec = reply.send(dealer);
 
     if (ec && ec != error::service_stopped)
@@ -250,8 +280,23 @@ bool notification_worker::handle_transaction_pool(const code& ec,
     return true;
 }
 
-// All payment keys are cached on the transaction.
+// static
 // This parsing is duplicated by bc::database::data_base.
+notification_worker::key_set notification_worker::to_keys(
+    const transaction& tx)
+{
+    key_set keys;
+
+    for (const auto& input: tx.inputs())
+        keys.insert(bc::system::sha256_hash(input.script().to_data(false)));
+
+    for (const auto& output: tx.outputs())
+        keys.insert(bc::system::sha256_hash(output.script().to_data(false)));
+
+    return keys;
+}
+
+// All payment keys are cached on the transaction.
 void notification_worker::notify_transaction(zmq::socket& dealer,
     size_t height, const transaction& tx)
 {
@@ -268,13 +313,7 @@ void notification_worker::notify_transaction(zmq::socket& dealer,
     key_set keys;
 
     if (!key_subscriptions_empty())
-    {
-        for (const auto& input: tx.inputs())
-            keys.insert(bc::system::sha256_hash(input.script().to_data(false)));
-
-        for (const auto& output: outputs)
-            keys.insert(bc::system::sha256_hash(output.script().to_data(false)));
-    }
+        keys = to_keys(tx);
 
     if (!stealth_subscriptions_empty())
     {
@@ -304,6 +343,7 @@ void notification_worker::notify(zmq::socket& dealer,
 
     // Accumulate updates, send notifications outside locks.
     std::vector<subscription> notifies;
+    std::vector<std::pair<subscription, hash_digest>> status_notifies;
 
     // Notify address subscribers, O(N + M).
     if (!keys.empty())
@@ -324,7 +364,11 @@ void notification_worker::notify(zmq::socket& dealer,
 #endif
             {
                 it->second.increment();
-                notifies.push_back(it->second);
+
+                if (it->second.status())
+                    status_notifies.emplace_back(it->second, it->first);
+                else
+                    notifies.push_back(it->second);
             }
         }
         ///////////////////////////////////////////////////////////////////////
@@ -335,6 +379,19 @@ void notification_worker::notify(zmq::socket& dealer,
         if (!send(dealer, notify, notification_key, ok, height, tx_hash))
             break;
 
+    // The balance cache is updated before notification (subscribed first).
+    // The status is null if the key has been evicted from the cache.
+    for (auto& notify: status_notifies)
+    {
+        balance_cache::balance balance;
+        const auto status = node_.balances().get(balance, notify.second) ?
+            balance.status : null_hash;
+
+        if (!send(dealer, notify.first, notification_key, ok, height, tx_hash,
+            status))
+            break;
+    }
+
     notifies.clear();
 
     // Notify stealth subscribers, O(24 * (N + M)).
@@ -486,7 +543,7 @@ bool notification_worker::stealth_subscriptions_empty() const
 }
 
 code notification_worker::subscribe_key(const message& request,
-    hash_digest&& key, bool unsubscribe)
+    hash_digest&& key, bool unsubscribe, bool status)
 {
     if (stopped())
         return error::service_stopped;
@@ -499,7 +556,8 @@ code notification_worker::subscribe_key(const message& request,
     auto range = left.equal_range(key);
 
     // Check each subscription for the given key.
-    // A change to the id is not considered (caller should not change).
+    // A change to the id or status is not considered (caller should not
+    // change).
     for (auto it = range.first; it != range.second; ++it)
     {
         if (it->second == request.route())
@@ -531,7 +589,7 @@ code notification_worker::subscribe_key(const message& request,
     key_subscriptions_.insert(
     {
         std::move(key),
-        { request.route(), request.id(), current_time() }
+        { request.route(), request.id(), current_time(), status }
     });
 
     key_mutex_.unlock();
@@ -584,7 +642,7 @@ code notification_worker::subscribe_stealth(const message& request,
     stealth_subscriptions_.insert(
     {
         std::move(prefix_filter),
-        { request.route(), request.id(), current_time() }
+        { request.route(), request.id(), current_time(), false }
     });
 
     stealth_mutex_.unlock();
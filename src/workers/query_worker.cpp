@@ -18,8 +18,12 @@
  */
 #include <bitcoin/server/workers/query_worker.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <string>
+#include <type_traits>
 #include <bitcoin/protocol.hpp>
 #include <bitcoin/server/define.hpp>
 #include <bitcoin/server/interface/blockchain.hpp>
@@ -29,6 +33,7 @@
 #include <bitcoin/server/interface/unsubscribe.hpp>
 #include <bitcoin/server/messages/message.hpp>
 #include <bitcoin/server/server_node.hpp>
+#include <bitcoin/server/utility/compressor.hpp>
 
 namespace libbitcoin {
 namespace server {
@@ -38,6 +43,19 @@ using namespace bc::protocol;
 using namespace bc::system;
 using role = zmq::socket::role;
 
+// Response compression, opted into per request by the command suffix.
+// The fastest level is used since the cost is paid on every response.
+static const std::string deflate_suffix = ".deflate";
+static constexpr uint8_t encoding_none = 0;
+static constexpr uint8_t encoding_deflate = 1;
+static constexpr int response_level = 1;
+
+// Request data size bounds.
+static constexpr size_t any_size = max_size_t;
+static constexpr size_t height_size = sizeof(uint32_t);
+static constexpr size_t point_size = hash_size + sizeof(uint32_t);
+static constexpr size_t key_height_size = hash_size + sizeof(uint32_t);
+
 query_worker::query_worker(zmq::authenticator& authenticator,
     server_node& node, bool secure)
   : worker(priority(node.server_settings().priority)),
@@ -52,6 +70,7 @@ query_worker::query_worker(zmq::authenticator& authenticator,
 {
     // The same interface is attached to the secure and public interfaces.
     attach_interface();
+    index();
 }
 
 // Implement worker as a dealer to the query service.
@@ -117,6 +136,53 @@ bool query_worker::disconnect(zmq::socket& dealer)
 // The dealer send blocks until the query service dealer is available.
 //-----------------------------------------------------------------------------
 
+// static
+bool query_worker::is_deflated(const std::string& command)
+{
+    const auto size = deflate_suffix.size();
+    return command.size() > size &&
+        command.compare(command.size() - size, size, deflate_suffix) == 0;
+}
+
+// static
+bool query_worker::is_deflated(const data_chunk& frame)
+{
+    const auto size = deflate_suffix.size();
+    return frame.size() > size && std::memcmp(&frame[frame.size() - size],
+        deflate_suffix.data(), size) == 0;
+}
+
+// A deflated command is answered with [encoding:1][payload], where the payload
+// is raw DEFLATE if it exceeds the threshold and compression reduces it.
+// private/static
+void query_worker::respond(const message& response, zmq::socket& dealer,
+    uint32_t threshold)
+{
+    if (!is_deflated(response.command()))
+    {
+        send(response, dealer);
+        return;
+    }
+
+    // Each responding thread reuses its stream, reset between responses.
+    static thread_local deflater response_deflater(response_level);
+
+    const auto& data = response.data();
+    data_chunk deflated;
+
+    if (threshold != 0 && data.size() > threshold &&
+        response_deflater.deflate(deflated, data) &&
+        deflated.size() < data.size())
+    {
+        send(message(response, build_chunk(
+            { to_array(encoding_deflate), deflated })), dealer);
+        return;
+    }
+
+    send(message(response, build_chunk(
+        { to_array(encoding_none), data })), dealer);
+}
+
 // private/static
 void query_worker::send(const message& response, zmq::socket& dealer)
 {
@@ -137,30 +203,26 @@ void query_worker::query(zmq::socket& dealer)
         return;
 
     message request(secure_);
-    const auto ec = request.receive(dealer);
+    const command* entry = nullptr;
+    const auto ec = request.receive(dealer,
+        [this, &entry](const data_chunk& frame, size_t size)
+        {
+            return validate(frame, size, entry);
+        });
 
     if (ec == error::service_stopped)
         return;
 
+    // Unknown commands and requests outside of the command size bounds are
+    // rejected before dispatch.
     if (ec)
     {
         LOG_DEBUG(LOG_SERVER)
             << "Failed to receive query from " << request.route().display()
             << " " << ec.message();
 
-        send(message(request, ec), dealer);
-        return;
-    }
-
-    // Locate the request handler for this command.
-    const auto handler = command_handlers_.find(request.command());
-
-    if (handler == command_handlers_.end())
-    {
-        LOG_DEBUG(LOG_SERVER)
-            << "Invalid query command from " << request.route().display();
-
-        send(message(request, error::not_found), dealer);
+        respond(message(request, ec), dealer,
+            settings_.query_compression_threshold);
         return;
     }
 
@@ -168,30 +230,104 @@ void query_worker::query(zmq::socket& dealer)
         << "Query " << request.command() << " from "
         << request.route().display();
 
-    // The query executor is the delegate bound by the attach method.
-    const auto& query_execute = handler->second;
-
     // Execute the request and send the result.
     // Example: address.renew(node_, request, sender);
     // Example: blockchain.fetch_history4(node_, request, sender);
-    query_execute(request,
-        std::bind(&query_worker::send,
-            _1, std::ref(dealer)));
+    entry->handler(node_, request,
+        std::bind(&query_worker::respond,
+            _1, std::ref(dealer), settings_.query_compression_threshold));
 }
 
 // Query Interface.
 // ----------------------------------------------------------------------------
 
 // Class and method names must match protocol expectations (do not change).
-#define ATTACH(class_name, method_name, node) \
-    attach(#class_name "." #method_name, \
-        std::bind(&bc::server::class_name::method_name, \
-            std::ref(node), _1, _2));
+// The name hash is computed at compile time.
+#define ATTACH(class_name, method_name, minimum, maximum) \
+    attach( \
+    { \
+        #class_name "." #method_name, \
+        sizeof(#class_name "." #method_name) - 1u, \
+        std::integral_constant<uint32_t, \
+            hash(#class_name "." #method_name)>::value, \
+        &bc::server::class_name::method_name, \
+        minimum, \
+        maximum \
+    })
+
+void query_worker::attach(const command& value)
+{
+    attached_.push_back(value);
+}
 
-void query_worker::attach(const std::string& command,
-    command_handler handler)
+// The table is at least twice the command count, so probing terminates at an
+// empty slot. Linear probing, a command of the same name is replaced.
+void query_worker::index()
 {
-    command_handlers_[command] = handler;
+    size_t slots = 1;
+    while (slots < 2u * attached_.size())
+        slots <<= 1;
+
+    const auto mask = slots - 1u;
+    commands_.assign(slots, command{ nullptr, 0, 0, nullptr, 0, 0 });
+
+    for (const auto& value: attached_)
+    {
+        for (auto probe = value.hash & mask;; probe = (probe + 1u) & mask)
+        {
+            auto& slot = commands_[probe];
+
+            if (slot.handler == nullptr || (slot.hash == value.hash &&
+                std::strcmp(slot.name, value.name) == 0))
+            {
+                slot = value;
+                break;
+            }
+        }
+    }
+}
+
+// The name is compared by hash and length before its text.
+const query_worker::command* query_worker::find(const uint8_t* name,
+    size_t length) const
+{
+    auto basis = 2166136261u;
+
+    for (size_t index = 0; index < length; ++index)
+        basis = (basis ^ name[index]) * 16777619u;
+
+    const auto mask = commands_.size() - 1u;
+
+    for (auto probe = basis & mask;; probe = (probe + 1u) & mask)
+    {
+        const auto& slot = commands_[probe];
+
+        if (slot.handler == nullptr)
+            return nullptr;
+
+        if (slot.hash == basis && slot.length == length &&
+            std::memcmp(slot.name, name, length) == 0)
+            return &slot;
+    }
+}
+
+// The command frame is looked up without any suffix and before it is decoded.
+code query_worker::validate(const data_chunk& frame, size_t size,
+    const command*& entry) const
+{
+    const auto length = frame.size() -
+        (is_deflated(frame) ? deflate_suffix.size() : 0u);
+
+    entry = find(frame.data(), length);
+
+    if (entry == nullptr)
+        return error::not_found;
+
+    // Requests that cannot be valid are rejected without dispatch.
+    if (size < entry->minimum || size > entry->maximum)
+        return error::bad_stream;
+
+    return error::success;
 }
 
 //=============================================================================
@@ -205,6 +341,8 @@ void query_worker::attach(const std::string& command,
 // address.renew is obsoleted in v3.
 // address.subscribe is obsoleted in v3.
 //-----------------------------------------------------------------------------
+// Any command suffixed with ".deflate" is new in v4.0 (framed response).
+//-----------------------------------------------------------------------------
 // blockchain.validate is new in v3 (blocks).
 // blockchain.broadcast is new in v3 (blocks).
 // blockchain.fetch_history is obsoleted in v3 (hash reversal).
@@ -212,17 +350,32 @@ void query_worker::attach(const std::string& command,
 // blockchain.fetch_history2 is obsoleted in v3.1 (version byte unused)
 // blockchain.fetch_history3 is new in v3.1 (no version byte)
 // blockchain.fetch_history4 is new in v4.0.
+// blockchain.fetch_history5 is new in v4.0 (options, transactions).
+// blockchain.fetch_history6 is new in v4.0 (compact encoding).
+// blockchain.fetch_unspent is new in v4.0.
+// blockchain.fetch_balance is new in v4.0.
+// blockchain.fetch_history_status is new in v4.0.
+// blockchain.fetch_history_delta is new in v4.0.
 // blockchain.fetch_stealth is obsoleted in v3 (hash reversal).
 // blockchain.fetch_stealth2 is new in v3.
 // blockchain.fetch_stealth2 is obsoleted in v4.
 // blockchain.fetch_stealth_transaction_hashes is new in v3 (safe version).
 // blockchain.fetch_stealth_transaction_hashes is obsoleted in v4.
 // blockchain.fetch_block (full) is new in v4.
+// blockchain.fetch_block_headers (range) is new in v4.
+// blockchain.fetch_block_range (streamed) is new in v4.
+// blockchain.fetch_transaction_with_prevouts is new in v4.
+// blockchain.fetch_transactions (batch) is new in v4.
+// blockchain.fetch_compact_filters (range) is new in v4.
+// blockchain.match_filters (range) is new in v4.
+// blockchain.fetch_merkle_proof is new in v4.
+// blockchain.fetch_spends (batch) is new in v4.
 //-----------------------------------------------------------------------------
 // transaction_pool.validate is obsoleted in v3 (unconfirmed outputs).
 // transaction_pool.validate2 is new in v3.
 // transaction_pool.broadcast is new in v3 (rename).
 // transaction_pool.fetch_transaction is enhanced in v3 (adds confirmed txs).
+// transaction_pool.fetch_transactions (batch) is new in v4.
 //-----------------------------------------------------------------------------
 // protocol.broadcast_transaction is obsoleted in v3 (renamed).
 // protocol.total_connections is obsoleted in v3 (administrative).
@@ -230,6 +383,7 @@ void query_worker::attach(const std::string& command,
 // subscribe.address is new in v3, also call for renew.
 // subscribe.address is obsoleted in v4 (see subscribe.key).
 // subscribe.key is new in v4, also call for renew.
+// subscribe.key is enhanced in v4 (optional status option byte).
 // subscribe.stealth is new in v3, also call for renew.
 // subscribe.stealth is obsoleted in v4.
 //-----------------------------------------------------------------------------
@@ -257,8 +411,8 @@ void query_worker::attach_interface()
     ////ATTACH(subscribe, stealth, node_);     // new (3.1), obsoleted (4.0)
     ////ATTACH(unsubscribe, stealth, node_);   // new (3.1), obsoleted (4.0)
 
-    ATTACH(subscribe, key, node_);                              // new (4.0)
-    ATTACH(unsubscribe, key, node_);                            // new (4.0)
+    ATTACH(subscribe, key, hash_size, hash_size + 1u);          // new (4.0)
+    ATTACH(unsubscribe, key, hash_size, hash_size);             // new (4.0)
 
     ////ATTACH(blockchain, fetch_stealth, node_);               // obsoleted
     ////ATTACH(blockchain, fetch_history, node_);               // obsoleted
@@ -267,29 +421,76 @@ void query_worker::attach_interface()
     ////                                       // new (3.0), obsoleted (4.0)
     ////ATTACH(blockchain, fetch_stealth_transaction_hashes, node_);
     ////                                       // new (3.0), obsoleted (4.0)
-    ATTACH(blockchain, fetch_block, node_);                     // new (4.0)
-    ATTACH(blockchain, fetch_block_header, node_);              // original
-    ATTACH(blockchain, fetch_block_height, node_);              // original
-    ATTACH(blockchain, fetch_block_transaction_hashes, node_);  // original
-    ATTACH(blockchain, fetch_last_height, node_);               // original
-    ATTACH(blockchain, fetch_transaction, node_);               // original
-    ATTACH(blockchain, fetch_transaction2, node_);              // new (3.4)
-    ATTACH(blockchain, fetch_transaction_index, node_);         // original
-    ATTACH(blockchain, fetch_spend, node_);                     // original
-    ATTACH(blockchain, fetch_history4, node_);                  // new (4.0)
-    ATTACH(blockchain, broadcast, node_);                       // new (3.0)
-    ATTACH(blockchain, validate, node_);                        // new (3.0)
-    ATTACH(blockchain, fetch_compact_filter, node_);            // new (4.0)
-    ATTACH(blockchain, fetch_compact_filter_checkpoint, node_); // new (4.0)
-    ATTACH(blockchain, fetch_compact_filter_headers, node_);    // new (4.0)
+    ATTACH(blockchain, fetch_block,
+        height_size, hash_size);                                // new (4.0)
+    ATTACH(blockchain, fetch_block_header,
+        height_size, hash_size);                                // original
+    ATTACH(blockchain, fetch_block_headers,
+        2u * height_size, 2u * height_size);                    // new (4.0)
+    ATTACH(blockchain, fetch_block_range,
+        3u * height_size, 3u * height_size);                    // new (4.0)
+    ATTACH(blockchain, fetch_block_height,
+        hash_size, hash_size);                                  // original
+    ATTACH(blockchain, fetch_block_transaction_hashes,
+        height_size, hash_size);                                // original
+    ATTACH(blockchain, fetch_last_height, 0, 0);                // original
+    ATTACH(blockchain, fetch_transaction,
+        hash_size, hash_size);                                  // original
+    ATTACH(blockchain, fetch_transaction2,
+        hash_size, hash_size);                                  // new (3.4)
+    ATTACH(blockchain, fetch_transactions,
+        hash_size, any_size);                                   // new (4.0)
+    ATTACH(blockchain, fetch_transaction_with_prevouts,
+        hash_size, hash_size);                                  // new (4.0)
+    ATTACH(blockchain, fetch_transaction_index,
+        hash_size, hash_size);                                  // original
+    ATTACH(blockchain, fetch_merkle_proof,
+        hash_size, hash_size);                                  // new (4.0)
+    ATTACH(blockchain, fetch_spend,
+        point_size, point_size);                                // original
+    ATTACH(blockchain, fetch_spends, hash_size, any_size);      // new (4.0)
+    ATTACH(blockchain, fetch_history4,
+        key_height_size, key_height_size);                      // new (4.0)
+    ATTACH(blockchain, fetch_history5,
+        key_height_size + 1u, key_height_size + 1u);            // new (4.0)
+    ATTACH(blockchain, fetch_history6,
+        key_height_size, key_height_size);                      // new (4.0)
+    ATTACH(blockchain, fetch_unspent,
+        key_height_size, key_height_size);                      // new (4.0)
+    ATTACH(blockchain, fetch_balance,
+        hash_size, hash_size);                                  // new (4.0)
+    ATTACH(blockchain, fetch_history_status,
+        hash_size, hash_size);                                  // new (4.0)
+    ATTACH(blockchain, fetch_history_delta,
+        key_height_size + hash_size,
+        key_height_size + hash_size);                           // new (4.0)
+    ATTACH(blockchain, broadcast, 1, any_size);                 // new (3.0)
+    ATTACH(blockchain, validate, 1, any_size);                  // new (3.0)
+    ATTACH(blockchain, fetch_compact_filter,
+        1u + height_size, 1u + hash_size);                      // new (4.0)
+    ATTACH(blockchain, fetch_compact_filters,
+        1u + height_size + hash_size,
+        1u + height_size + hash_size);                          // new (4.0)
+    ATTACH(blockchain, match_filters,
+        2u * height_size + 1u, any_size);                       // new (4.0)
+    ATTACH(blockchain, fetch_compact_filter_checkpoint,
+        1u + hash_size, 1u + hash_size);                        // new (4.0)
+    ATTACH(blockchain, fetch_compact_filter_headers,
+        1u + 2u * height_size,
+        1u + height_size + hash_size);                          // new (4.0)
 
     ////ATTACH(transaction_pool, validate, node_);              // obsoleted
-    ATTACH(transaction_pool, fetch_transaction, node_);         // enhanced (3.0)
-    ATTACH(transaction_pool, fetch_transaction2, node_);        // new (3.4)
-    ATTACH(transaction_pool, broadcast, node_);                 // new (3.0)
-    ATTACH(transaction_pool, validate2, node_);                 // new (3.0)
-
-    ATTACH(server, version, node_);                             // new (4.0)
+    ATTACH(transaction_pool, fetch_transaction,
+        hash_size, hash_size);                                  // enhanced (3.0)
+    ATTACH(transaction_pool, fetch_transaction2,
+        hash_size, hash_size);                                  // new (3.4)
+    ATTACH(transaction_pool, fetch_transactions,
+        hash_size, any_size);                                   // new (4.0)
+    ATTACH(transaction_pool, broadcast, 1, any_size);           // new (3.0)
+    ATTACH(transaction_pool, validate2, 1, any_size);           // new (3.0)
+
+    ATTACH(server, version, 0, any_size);                       // new (4.0)
+    ATTACH(server, fetch_websocket_metrics, 0, any_size);       // new (4.0)
 
     ////ATTACH(protocol, broadcast_transaction, node_);         // obsoleted
     ////ATTACH(protocol, total_connections, node_);             // obsoleted
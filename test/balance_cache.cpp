@@ -0,0 +1,234 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+using namespace bc::system::chain;
+
+BOOST_AUTO_TEST_SUITE(balance_cache_tests)
+
+static const script script1(data_chunk{ 0x51 }, false);
+static const script script2(data_chunk{ 0x52 }, false);
+
+static hash_digest hash_of(uint8_t value)
+{
+    hash_digest hash = null_hash;
+    hash[0] = value;
+    return hash;
+}
+
+static hash_digest digest(const hash_digest& tx_hash, uint32_t height)
+{
+    return sha256_hash(build_chunk({ tx_hash, to_little_endian(height) }));
+}
+
+static hash_digest xor_of(const hash_digest& left, const hash_digest& right)
+{
+    hash_digest out;
+
+    for (size_t index = 0; index < out.size(); ++index)
+        out[index] = left[index] ^ right[index];
+
+    return out;
+}
+
+static payment_record new_record(const hash_digest& hash, size_t height,
+    uint32_t index, uint64_t data, bool output)
+{
+    payment_record record(height, index, data, output);
+    record.set_hash(hash_digest(hash));
+    return record;
+}
+
+static transaction new_transaction(const output_point& spend,
+    const script& script, uint64_t value)
+{
+    return transaction(1, 0, { input(spend, {}, 0) },
+        { output(value, script) });
+}
+
+static block_const_ptr_list new_blocks(const transaction::list& txs)
+{
+    return
+    {
+        std::make_shared<const system::message::block>(chain::header{}, txs)
+    };
+}
+
+// Cache the key with a confirmed output of 100 at (hash_of(1), 0).
+static void populate(balance_cache& cache, const hash_digest& key,
+    const payment_record::list& payments = {})
+{
+    auto history = payments;
+    history.push_back(new_record(hash_of(1), 1, 0, 100, true));
+
+    balance_cache::pool_deltas pool;
+    balance_cache::point_values unspent;
+    const auto balance = balance_cache::compute(history, pool, unspent);
+    BOOST_REQUIRE(cache.put(key, balance, pool, unspent, cache.sequence()));
+}
+
+BOOST_AUTO_TEST_CASE(balance_cache__toggle__twice__null_hash)
+{
+    auto status = null_hash;
+    balance_cache::toggle(status, hash_of(1), 42);
+    BOOST_REQUIRE(status == digest(hash_of(1), 42));
+    balance_cache::toggle(status, hash_of(1), 42);
+    BOOST_REQUIRE(status == null_hash);
+}
+
+BOOST_AUTO_TEST_CASE(balance_cache__compute__distinct_entries__xor_of_digests)
+{
+    // The spend and output records of one transaction are one entry.
+    const payment_record::list payments
+    {
+        new_record(hash_of(1), 10, 0, 100, true),
+        new_record(hash_of(2), 20, 0,
+            output_point{ hash_of(1), 0 }.checksum(), false),
+        new_record(hash_of(2), 20, 1, 60, true),
+        new_record(hash_of(3), max_uint32, 0, 5, true)
+    };
+
+    balance_cache::pool_deltas pool;
+    balance_cache::point_values unspent;
+    const auto result = balance_cache::compute(payments, pool, unspent);
+
+    const auto expected = xor_of(xor_of(digest(hash_of(1), 10),
+        digest(hash_of(2), 20)), digest(hash_of(3), max_uint32));
+
+    BOOST_REQUIRE(result.status == expected);
+    BOOST_REQUIRE_EQUAL(result.confirmed, 60u);
+    BOOST_REQUIRE_EQUAL(result.unconfirmed, 5);
+    BOOST_REQUIRE_EQUAL(result.transactions, 2u);
+    BOOST_REQUIRE_EQUAL(result.first_height, 10u);
+    BOOST_REQUIRE_EQUAL(result.last_height, 20u);
+    BOOST_REQUIRE_EQUAL(pool.size(), 1u);
+    BOOST_REQUIRE_EQUAL(pool[hash_of(3)].value, 5);
+
+    // The confirmed spend excludes the spent output.
+    BOOST_REQUIRE_EQUAL(unspent.size(), 2u);
+    BOOST_REQUIRE(unspent.find(output_point{ hash_of(1), 0 }.checksum()) ==
+        unspent.end());
+}
+
+BOOST_AUTO_TEST_CASE(balance_cache__compute__reordered__same_status)
+{
+    const auto first = new_record(hash_of(1), 10, 0, 100, true);
+    const auto second = new_record(hash_of(2), 11, 0, 7, true);
+
+    balance_cache::pool_deltas pool;
+    balance_cache::point_values unspent;
+    const auto forward = balance_cache::compute({ first, second }, pool,
+        unspent);
+    const auto reverse = balance_cache::compute({ second, first }, pool,
+        unspent);
+    BOOST_REQUIRE(forward.status == reverse.status);
+}
+
+BOOST_AUTO_TEST_CASE(balance_cache__put__key_announced__false)
+{
+    balance_cache cache(10);
+    const auto key = payment_key::to_key(script1);
+    const auto sequence = cache.sequence();
+    cache.notify(new_transaction({ hash_of(9), 0 }, script1, 1));
+    BOOST_REQUIRE(!cache.put(key, {}, {}, {}, sequence));
+    BOOST_REQUIRE(cache.put(key, {}, {}, {}, cache.sequence()));
+}
+
+BOOST_AUTO_TEST_CASE(balance_cache__reorganize__spend_without_prevout__debited)
+{
+    balance_cache cache(10);
+    const auto key = payment_key::to_key(script1);
+    populate(cache, key);
+
+    // The input carries no previous output, it is valued from the cache.
+    cache.reorganize(0, new_blocks(
+    {
+        new_transaction({ hash_of(1), 0 }, script2, 100)
+    }));
+
+    balance_cache::balance balance;
+    BOOST_REQUIRE(cache.get(balance, key));
+    BOOST_REQUIRE_EQUAL(balance.confirmed, 0u);
+    BOOST_REQUIRE_EQUAL(balance.transactions, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(balance_cache__notify__confirmed__unconfirmed_reversed)
+{
+    balance_cache cache(10);
+    const auto key = payment_key::to_key(script1);
+    populate(cache, key);
+
+    const auto tx = new_transaction({ hash_of(1), 0 }, script2, 100);
+    cache.notify(tx);
+
+    balance_cache::balance balance;
+    BOOST_REQUIRE(cache.get(balance, key));
+    BOOST_REQUIRE_EQUAL(balance.unconfirmed, -100);
+    BOOST_REQUIRE_EQUAL(balance.confirmed, 100u);
+
+    cache.reorganize(0, new_blocks({ tx }));
+    BOOST_REQUIRE(cache.get(balance, key));
+    BOOST_REQUIRE_EQUAL(balance.unconfirmed, 0);
+    BOOST_REQUIRE_EQUAL(balance.confirmed, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(balance_cache__reorganize__conflicting_spend__evicted)
+{
+    balance_cache cache(10);
+    const auto key = payment_key::to_key(script1);
+    populate(cache, key);
+    cache.notify(new_transaction({ hash_of(1), 0 }, script2, 100));
+
+    // A distinct transaction confirms a spend of the same point.
+    cache.reorganize(0, new_blocks(
+    {
+        new_transaction({ hash_of(1), 0 }, script2, 99)
+    }));
+
+    balance_cache::balance balance;
+    BOOST_REQUIRE(!cache.get(balance, key));
+}
+
+BOOST_AUTO_TEST_CASE(balance_cache__reorganize__pool_outlived__evicted)
+{
+    balance_cache cache(10);
+    const auto key = payment_key::to_key(script1);
+    populate(cache, key);
+    cache.notify(new_transaction({ hash_of(8), 0 }, script1, 5));
+
+    for (size_t height = 0; height < 6; ++height)
+        cache.reorganize(height, new_blocks({}));
+
+    balance_cache::balance balance;
+    BOOST_REQUIRE(cache.get(balance, key));
+    BOOST_REQUIRE_EQUAL(balance.unconfirmed, 5);
+
+    cache.reorganize(6, new_blocks({}));
+    BOOST_REQUIRE(!cache.get(balance, key));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+
+BOOST_AUTO_TEST_SUITE(compressor_tests)
+
+static data_chunk repetitive(size_t size)
+{
+    data_chunk data(size);
+    for (size_t index = 0; index < size; ++index)
+        data[index] = static_cast<uint8_t>(index % 7);
+
+    return data;
+}
+
+BOOST_AUTO_TEST_CASE(compressor__deflate__empty__final_empty_block)
+{
+    const compressor instance(1);
+    data_chunk out;
+    BOOST_REQUIRE(instance.deflate(out, {}));
+
+    // A raw final static block with only end of block, no zlib header.
+    BOOST_REQUIRE(out == data_chunk({ 0x03, 0x00 }));
+}
+
+BOOST_AUTO_TEST_CASE(compressor__deflate__repetitive__smaller_and_round_trips)
+{
+    const compressor instance(1);
+    const auto data = repetitive(4096);
+    data_chunk deflated;
+    BOOST_REQUIRE(instance.deflate(deflated, data));
+    BOOST_REQUIRE_LT(deflated.size(), data.size());
+
+    data_chunk inflated;
+    BOOST_REQUIRE(instance.inflate(inflated, deflated));
+    BOOST_REQUIRE(inflated == data);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__inflate__other_level__round_trips)
+{
+    const compressor fast(1);
+    const compressor best(9);
+    const auto data = repetitive(1000);
+    data_chunk deflated;
+    BOOST_REQUIRE(best.deflate(deflated, data));
+
+    data_chunk inflated;
+    BOOST_REQUIRE(fast.inflate(inflated, deflated));
+    BOOST_REQUIRE(inflated == data);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__deflate__repeated__deterministic)
+{
+    const compressor instance(6);
+    const auto data = repetitive(2048);
+    data_chunk first;
+    data_chunk second;
+    BOOST_REQUIRE(instance.deflate(first, data));
+    BOOST_REQUIRE(instance.deflate(second, data));
+    BOOST_REQUIRE(first == second);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__inflate__invalid__false)
+{
+    const compressor instance(1);
+
+    // Block type 3 is reserved.
+    data_chunk out;
+    BOOST_REQUIRE(!instance.inflate(out, { 0x07, 0x00, 0x00 }));
+}
+
+BOOST_AUTO_TEST_CASE(deflater__deflate__reused__matches_compressor)
+{
+    const compressor instance(1);
+    deflater stream(1);
+    const auto large = repetitive(20000);
+    const data_chunk small{ 1, 2, 3 };
+
+    data_chunk expected;
+    data_chunk deflated;
+    data_chunk inflated;
+
+    // The stream is reset between messages, so each is independent.
+    for (const auto& data: { large, small, large })
+    {
+        BOOST_REQUIRE(instance.deflate(expected, data));
+        BOOST_REQUIRE(stream.deflate(deflated, data));
+        BOOST_REQUIRE(deflated == expected);
+        BOOST_REQUIRE(instance.inflate(inflated, deflated));
+        BOOST_REQUIRE(inflated == data);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(deflater__deflate__empty__final_empty_block)
+{
+    deflater stream(1);
+    data_chunk out;
+    BOOST_REQUIRE(stream.deflate(out, {}));
+    BOOST_REQUIRE(out == data_chunk({ 0x03, 0x00 }));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
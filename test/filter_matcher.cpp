@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <string>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+
+BOOST_AUTO_TEST_SUITE(filter_matcher_tests)
+
+static data_chunk base16(const std::string& text)
+{
+    data_chunk out;
+    BOOST_REQUIRE(decode_base16(out, text));
+    return out;
+}
+
+static hash_digest hash(const std::string& text)
+{
+    hash_digest out;
+    BOOST_REQUIRE(decode_hash(out, text));
+    return out;
+}
+
+// BIP158 test vector, testnet block 0 (testnet-19.json).
+static const std::string genesis_hash =
+    "000000000933ea01ad0ee984209779baaec3ced90fa3f408719526f8d77f4943";
+static const std::string genesis_filter = "019dfca8";
+static const std::string genesis_script =
+    "4104678afdb0fe5548271967f1a67130b7105cd6a828e03909a67962e0ea1f61deb649f6"
+    "bc3f4cef38c4f35504e51ec112de5c384df7ba0b8d578a4c702b6bf11d5fac";
+
+// SipHash-2-4 reference vectors, key 00..0f and message 00..(size - 1).
+static uint64_t reference_siphash(size_t size)
+{
+    data_chunk message(size);
+    for (size_t index = 0; index < size; ++index)
+        message[index] = static_cast<uint8_t>(index);
+
+    return filter_matcher::siphash(0x0706050403020100, 0x0f0e0d0c0b0a0908,
+        message);
+}
+
+BOOST_AUTO_TEST_CASE(filter_matcher__siphash__reference_vectors__expected)
+{
+    BOOST_REQUIRE_EQUAL(reference_siphash(0), 0x726fdb47dd0e0e31u);
+    BOOST_REQUIRE_EQUAL(reference_siphash(8), 0x93f5f5799a932462u);
+    BOOST_REQUIRE_EQUAL(reference_siphash(15), 0xa129ca6149be45e5u);
+}
+
+BOOST_AUTO_TEST_CASE(filter_matcher__match__genesis_coinbase_script__true)
+{
+    const filter_matcher matcher({ base16(genesis_script) });
+    BOOST_REQUIRE(matcher.match(hash(genesis_hash), base16(genesis_filter)));
+}
+
+BOOST_AUTO_TEST_CASE(filter_matcher__match__any_element_matching__true)
+{
+    const filter_matcher matcher(
+    {
+        base16("51"),
+        base16(genesis_script),
+        base16("0014000000000000000000000000000000000000000000")
+    });
+
+    BOOST_REQUIRE(matcher.match(hash(genesis_hash), base16(genesis_filter)));
+}
+
+BOOST_AUTO_TEST_CASE(filter_matcher__match__other_script__false)
+{
+    const filter_matcher matcher(
+    {
+        base16("51"),
+        base16("76a914000000000000000000000000000000000000000088ac")
+    });
+
+    BOOST_REQUIRE(!matcher.match(hash(genesis_hash), base16(genesis_filter)));
+}
+
+BOOST_AUTO_TEST_CASE(filter_matcher__match__other_block_hash__false)
+{
+    // The testnet block 2 hash keys the elements differently.
+    const filter_matcher matcher({ base16(genesis_script) });
+    BOOST_REQUIRE(!matcher.match(hash(
+        "000000006c02c8ea6e4ff69651f7fcde348fb9d557a06e6957b65552002a7820"),
+        base16(genesis_filter)));
+}
+
+BOOST_AUTO_TEST_CASE(filter_matcher__match__no_elements__false)
+{
+    const filter_matcher matcher({});
+    BOOST_REQUIRE(!matcher.match(hash(genesis_hash), base16(genesis_filter)));
+}
+
+BOOST_AUTO_TEST_CASE(filter_matcher__match__empty_or_truncated_filter__false)
+{
+    const filter_matcher matcher({ base16(genesis_script) });
+    BOOST_REQUIRE(!matcher.match(hash(genesis_hash), base16("00")));
+    BOOST_REQUIRE(!matcher.match(hash(genesis_hash), base16("019d")));
+    BOOST_REQUIRE(!matcher.match(hash(genesis_hash), {}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
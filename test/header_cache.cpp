@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+
+BOOST_AUTO_TEST_SUITE(header_cache_tests)
+
+static chain::header new_header(const hash_digest& previous, uint32_t nonce)
+{
+    return chain::header(1, previous, null_hash, 0, 0, nonce);
+}
+
+static block_const_ptr new_block(const chain::header& header)
+{
+    return std::make_shared<const system::message::block>(header,
+        chain::transaction::list{});
+}
+
+// Push a chain of count headers from genesis, varied by nonce.
+static chain::header::list populate(header_cache& cache, size_t count,
+    uint32_t nonce)
+{
+    chain::header::list headers;
+    auto previous = null_hash;
+
+    for (size_t height = 0; height < count; ++height)
+    {
+        headers.push_back(new_header(previous, nonce));
+        previous = headers.back().hash();
+        BOOST_REQUIRE(cache.push(height, headers.back()));
+    }
+
+    return headers;
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__push__linked__cached)
+{
+    header_cache cache;
+    const auto headers = populate(cache, 3, 0);
+    BOOST_REQUIRE_EQUAL(cache.size(), 3u);
+
+    data_chunk out;
+    BOOST_REQUIRE(cache.get_header(out, 2));
+    BOOST_REQUIRE(out == headers[2].to_data());
+
+    size_t height;
+    BOOST_REQUIRE(cache.get_height(height, headers[1].hash()));
+    BOOST_REQUIRE_EQUAL(height, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__push__not_top__false)
+{
+    header_cache cache;
+    const auto headers = populate(cache, 2, 0);
+    BOOST_REQUIRE(!cache.push(1, new_header(headers[0].hash(), 1)));
+    BOOST_REQUIRE(!cache.push(3, new_header(headers[1].hash(), 1)));
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__push__unlinked__false)
+{
+    header_cache cache;
+    populate(cache, 2, 0);
+    BOOST_REQUIRE(!cache.push(2, new_header(null_hash, 1)));
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__get_headers__beyond_top__truncated)
+{
+    header_cache cache;
+    populate(cache, 5, 0);
+
+    data_chunk out;
+    BOOST_REQUIRE_EQUAL(cache.get_headers(out, 3, 10), 2u);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u * header_cache::header_size);
+    BOOST_REQUIRE_EQUAL(cache.get_headers(out, 5, 10), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__reorganize__fork_above_top__false)
+{
+    header_cache cache;
+    const auto headers = populate(cache, 3, 0);
+    const auto incoming = new_block(new_header(headers[2].hash(), 1));
+    BOOST_REQUIRE(!cache.reorganize(3, { incoming }));
+    BOOST_REQUIRE_EQUAL(cache.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__reorganize__fork_below_top__replaced)
+{
+    header_cache cache;
+    const auto headers = populate(cache, 4, 0);
+    const auto first = new_block(new_header(headers[1].hash(), 1));
+    const auto second = new_block(new_header(first->header().hash(), 1));
+    BOOST_REQUIRE(cache.reorganize(1, { first, second }));
+    BOOST_REQUIRE_EQUAL(cache.size(), 4u);
+
+    size_t height;
+    BOOST_REQUIRE(!cache.get_height(height, headers[2].hash()));
+    BOOST_REQUIRE(!cache.get_height(height, headers[3].hash()));
+    BOOST_REQUIRE(cache.get_height(height, second->header().hash()));
+    BOOST_REQUIRE_EQUAL(height, 3u);
+
+    data_chunk out;
+    BOOST_REQUIRE(cache.get_header(out, 2));
+    BOOST_REQUIRE(out == first->header().to_data());
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__push__superseded_read__false)
+{
+    header_cache cache;
+    const auto headers = populate(cache, 3, 0);
+    const auto incoming = new_block(new_header(headers[0].hash(), 1));
+    BOOST_REQUIRE(cache.reorganize(0, { incoming }));
+
+    // A read of the replaced chain at the new top does not link.
+    BOOST_REQUIRE(!cache.push(2, headers[2]));
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__pop__top__removed)
+{
+    header_cache cache;
+    const auto headers = populate(cache, 3, 0);
+    BOOST_REQUIRE(cache.pop(2));
+    BOOST_REQUIRE_EQUAL(cache.size(), 2u);
+
+    size_t height;
+    BOOST_REQUIRE(!cache.get_height(height, headers[2].hash()));
+
+    // A replacement for the popped header links to the new top.
+    BOOST_REQUIRE(cache.push(2, new_header(headers[1].hash(), 1)));
+}
+
+BOOST_AUTO_TEST_CASE(header_cache__pop__not_top__false)
+{
+    header_cache cache;
+    populate(cache, 3, 0);
+    BOOST_REQUIRE(!cache.pop(1));
+    BOOST_REQUIRE(!cache.pop(3));
+    BOOST_REQUIRE_EQUAL(cache.size(), 3u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,201 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+using namespace bc::system::chain;
+
+BOOST_AUTO_TEST_SUITE(history_cache_tests)
+
+static const script script1(data_chunk{ 0x51 }, false);
+static const script script2(data_chunk{ 0x52 }, false);
+
+static hash_digest hash_of(uint8_t value)
+{
+    hash_digest hash = null_hash;
+    hash[0] = value;
+    return hash;
+}
+
+static payment_record new_record(const hash_digest& hash, size_t height,
+    uint64_t data, bool output)
+{
+    payment_record record(height, 0, data, output);
+    record.set_hash(hash_digest(hash));
+    return record;
+}
+
+static transaction new_transaction(const output_point& spend,
+    const script& script)
+{
+    return transaction(1, 0, { input(spend, {}, 0) }, { output(1, script) });
+}
+
+// The point with the previous output cached as by validation.
+static output_point resolved(const output_point& point, const script& script)
+{
+    auto out = point;
+    out.metadata.cache = output(1, script);
+    return out;
+}
+
+static block_const_ptr_list new_blocks(const transaction::list& txs)
+{
+    return
+    {
+        std::make_shared<const system::message::block>(chain::header{}, txs)
+    };
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__put__pool_key_announced__false)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    const auto sequence = cache.sequence();
+    cache.notify(new_transaction({ hash_of(1), 0 }, script1));
+    BOOST_REQUIRE(!cache.put(key, {}, sequence));
+    BOOST_REQUIRE(cache.put(key, {}, cache.sequence()));
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__put__other_pool_key_announced__true)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    const auto sequence = cache.sequence();
+    cache.notify(new_transaction(resolved({ hash_of(1), 0 }, script2),
+        script2));
+    BOOST_REQUIRE(cache.put(key, {}, sequence));
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__put__unresolved_pool_input_announced__false)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    const auto sequence = cache.sequence();
+    cache.notify(new_transaction({ hash_of(1), 0 }, script2));
+    BOOST_REQUIRE(!cache.put(key, {}, sequence));
+    BOOST_REQUIRE(cache.put(key, {}, cache.sequence()));
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__put__reorganized__false)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    const auto sequence = cache.sequence();
+    cache.reorganize(0, new_blocks({}));
+    BOOST_REQUIRE(!cache.put(key, {}, sequence));
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__get__cached__hit)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    const auto record = new_record(hash_of(1), 10, 42, true);
+    BOOST_REQUIRE(cache.put(key, { record }, cache.sequence()));
+
+    payment_record::list out;
+    BOOST_REQUIRE(cache.get(out, key, 5));
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE_EQUAL(out.front().data(), 42u);
+    BOOST_REQUIRE_EQUAL(cache.hits(), 1u);
+
+    out.clear();
+    BOOST_REQUIRE(cache.get(out, key, 11));
+    BOOST_REQUIRE(out.empty());
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__reorganize__spend_without_prevout__appended)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    const output_point point{ hash_of(1), 0 };
+    const auto record = new_record(hash_of(1), 1, 100, true);
+    BOOST_REQUIRE(cache.put(key, { record }, cache.sequence()));
+
+    // The input carries no previous output, it is attributed by the cache.
+    cache.reorganize(1, new_blocks({ new_transaction(point, script2) }));
+
+    payment_record::list out;
+    BOOST_REQUIRE(cache.get(out, key, 0));
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(!out.back().is_output());
+    BOOST_REQUIRE_EQUAL(out.back().height(), 2u);
+    BOOST_REQUIRE_EQUAL(out.back().data(), point.checksum());
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__notify__spend_of_appended_output__appended)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    BOOST_REQUIRE(cache.put(key, {}, cache.sequence()));
+
+    const auto funding = new_transaction({ hash_of(1), 0 }, script1);
+    cache.reorganize(0, new_blocks({ funding }));
+    cache.notify(new_transaction({ funding.hash(), 0 }, script2));
+
+    payment_record::list out;
+    BOOST_REQUIRE(cache.get(out, key, 0));
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(out.front().is_output());
+    BOOST_REQUIRE(!out.back().is_output());
+    BOOST_REQUIRE_EQUAL(out.back().height(), max_uint32);
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__reorganize__conflicting_spend__evicted)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    const output_point point{ hash_of(1), 0 };
+    const auto spend = new_record(hash_of(2), max_uint32, point.checksum(),
+        false);
+    BOOST_REQUIRE(cache.put(key, { spend }, cache.sequence()));
+
+    // A distinct transaction confirms a spend of the same point.
+    cache.reorganize(0, new_blocks({ new_transaction(point, script2) }));
+
+    payment_record::list out;
+    BOOST_REQUIRE(!cache.get(out, key, 0));
+}
+
+BOOST_AUTO_TEST_CASE(history_cache__reorganize__unconfirmed_outlived__evicted)
+{
+    history_cache cache(1000000);
+    const auto key = payment_key::to_key(script1);
+    const auto unconfirmed = new_record(hash_of(2), max_uint32, 1, true);
+    BOOST_REQUIRE(cache.put(key, { unconfirmed }, cache.sequence()));
+
+    payment_record::list out;
+
+    for (size_t height = 0; height < 6; ++height)
+        cache.reorganize(height, new_blocks({}));
+
+    BOOST_REQUIRE(cache.get(out, key, 0));
+
+    cache.reorganize(6, new_blocks({}));
+    BOOST_REQUIRE(!cache.get(out, key, 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
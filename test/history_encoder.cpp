@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+using namespace bc::system::chain;
+
+BOOST_AUTO_TEST_SUITE(history_encoder_tests)
+
+static hash_digest new_hash(uint8_t fill)
+{
+    hash_digest hash;
+    hash.fill(fill);
+    return hash;
+}
+
+static payment_record new_record(uint8_t fill, size_t height, uint32_t index,
+    uint64_t data, bool output)
+{
+    payment_record record(height, index, data, output);
+    record.set_hash(new_hash(fill));
+    return record;
+}
+
+static data_chunk concatenate(const data_stack& parts)
+{
+    data_chunk out;
+
+    for (const auto& part: parts)
+        out.insert(out.end(), part.begin(), part.end());
+
+    return out;
+}
+
+static data_chunk hash_chunk(uint8_t fill)
+{
+    const auto hash = new_hash(fill);
+    return data_chunk(hash.begin(), hash.end());
+}
+
+BOOST_AUTO_TEST_CASE(history_encoder__encode__empty__zero_counts)
+{
+    BOOST_REQUIRE(history_encoder::encode({}) == data_chunk({ 0x00, 0x00 }));
+}
+
+BOOST_AUTO_TEST_CASE(history_encoder__encode__prefix__zeroed_prefix)
+{
+    const auto encoded = history_encoder::encode({}, 4);
+    BOOST_REQUIRE(encoded == data_chunk({ 0, 0, 0, 0, 0x00, 0x00 }));
+}
+
+BOOST_AUTO_TEST_CASE(history_encoder__encode__records__expected)
+{
+    const payment_record::list payments
+    {
+        new_record(2, 200, 1, 0x0102030405060708, false),
+        new_record(1, 100, 0, 5000, true),
+        new_record(2, 200, 3, 1, true),
+        new_record(3, max_uint32, 0, 300, true)
+    };
+
+    const auto expected = concatenate(
+    {
+        // Distinct hashes in height order.
+        { 0x03 }, hash_chunk(1), hash_chunk(2), hash_chunk(3),
+        { 0x04 },
+
+        // Output of hash 0 at height 100 (delta 100) of 5000.
+        { 0x01, 0x00, 0x00, 0x64, 0xfd, 0x88, 0x13 },
+
+        // Spend of hash 1 at height 200 (delta 100) with its checksum.
+        { 0x00, 0x01, 0x01, 0x64,
+          0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01 },
+
+        // Output of hash 1 at the same height (delta 0) of 1.
+        { 0x01, 0x01, 0x03, 0x00, 0x01 },
+
+        // Unconfirmed output of hash 2 (no delta) of 300.
+        { 0x03, 0x02, 0x00, 0xfd, 0x2c, 0x01 }
+    });
+
+    BOOST_REQUIRE(history_encoder::encode(payments) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(history_encoder__encode__same_height__record_order_kept)
+{
+    const payment_record::list payments
+    {
+        new_record(1, 10, 7, 1, true),
+        new_record(1, 10, 2, 1, true)
+    };
+
+    const auto expected = concatenate(
+    {
+        { 0x01 }, hash_chunk(1), { 0x02 },
+        { 0x01, 0x00, 0x07, 0x0a, 0x01 },
+        { 0x01, 0x00, 0x02, 0x00, 0x01 }
+    });
+
+    BOOST_REQUIRE(history_encoder::encode(payments) == expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <string>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+
+BOOST_AUTO_TEST_SUITE(merkle_cache_tests)
+
+static hash_digest hash(const std::string& text)
+{
+    hash_digest out;
+    BOOST_REQUIRE(decode_hash(out, text));
+    return out;
+}
+
+// Mainnet block 100000.
+static const hash_list block_100000
+{
+    hash("8c14f0db3df150123e6f3dbbf30f8b955a8249b62ac1d1ff16284aefa3d06d87"),
+    hash("fff2525b8931402dd09222c50775608f75787bd2b87e56995a7bdd30f79702c4"),
+    hash("6359f0868171b1d194cbee1af2f16ea598ae8fad666d9b012c8ed2b79a236ec4"),
+    hash("e9a66845e05d5abc0ad04ec80f774a7e585c6e8db975962d069a522137b80c1d")
+};
+
+static const auto root_100000 =
+    hash("f3e94742aca4b5ef85488dc37c06c3282295ffec960994b2c0d5ac2a25a95766");
+
+// Fold the branch of the position from the leaf to the root.
+static hash_digest to_root(const hash_digest& leaf, const hash_list& branch,
+    size_t position)
+{
+    auto root = leaf;
+
+    for (const auto& sibling: branch)
+    {
+        root = (position & 1u) == 0 ?
+            bitcoin_hash(build_chunk({ root, sibling })) :
+            bitcoin_hash(build_chunk({ sibling, root }));
+
+        position >>= 1;
+    }
+
+    return root;
+}
+
+static hash_list new_hashes(size_t count)
+{
+    hash_list hashes;
+
+    for (size_t index = 0; index < count; ++index)
+        hashes.push_back(bitcoin_hash(data_chunk{
+            static_cast<uint8_t>(index) }));
+
+    return hashes;
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__to_levels__empty__empty)
+{
+    BOOST_REQUIRE(merkle_cache::to_levels({}).empty());
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__to_levels__single__root_is_hash)
+{
+    const auto levels = merkle_cache::to_levels({ block_100000.front() });
+    BOOST_REQUIRE_EQUAL(levels.size(), 1u);
+    BOOST_REQUIRE(levels.back().front() == block_100000.front());
+    BOOST_REQUIRE(merkle_cache::to_branch(levels, 0).empty());
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__to_levels__block_100000__expected_root)
+{
+    const auto levels = merkle_cache::to_levels(block_100000);
+    BOOST_REQUIRE_EQUAL(levels.size(), 3u);
+    BOOST_REQUIRE_EQUAL(levels[1].size(), 2u);
+    BOOST_REQUIRE_EQUAL(levels.back().size(), 1u);
+    BOOST_REQUIRE(levels.back().front() == root_100000);
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__to_branch__block_100000__folds_to_root)
+{
+    const auto levels = merkle_cache::to_levels(block_100000);
+
+    for (size_t position = 0; position < block_100000.size(); ++position)
+    {
+        const auto branch = merkle_cache::to_branch(levels, position);
+        BOOST_REQUIRE_EQUAL(branch.size(), 2u);
+        BOOST_REQUIRE(to_root(block_100000[position], branch, position) ==
+            root_100000);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__to_branch__odd_count__last_paired_with_self)
+{
+    const auto hashes = new_hashes(5);
+    const auto levels = merkle_cache::to_levels(hashes);
+    const auto root = levels.back().front();
+    BOOST_REQUIRE_EQUAL(levels.size(), 4u);
+
+    const auto branch = merkle_cache::to_branch(levels, 4);
+    BOOST_REQUIRE(branch.front() == hashes[4]);
+
+    for (size_t position = 0; position < hashes.size(); ++position)
+        BOOST_REQUIRE(to_root(hashes[position],
+            merkle_cache::to_branch(levels, position), position) == root);
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__get_branch__put_at_sequence__cached)
+{
+    merkle_cache cache(2);
+    const auto levels = merkle_cache::to_levels(block_100000);
+    BOOST_REQUIRE(cache.put(100000, levels, cache.sequence()));
+
+    hash_list branch;
+    BOOST_REQUIRE(cache.get_branch(branch, 100000, 3));
+    BOOST_REQUIRE(branch == merkle_cache::to_branch(levels, 3));
+    BOOST_REQUIRE(!cache.get_branch(branch, 100000, 4));
+    BOOST_REQUIRE(!cache.get_branch(branch, 99999, 0));
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__put__stale_sequence__false)
+{
+    merkle_cache cache(2);
+    const auto sequence = cache.sequence();
+    cache.reorganize(10, {});
+    BOOST_REQUIRE(!cache.put(5, merkle_cache::to_levels(block_100000),
+        sequence));
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__put__over_limit__least_recent_evicted)
+{
+    merkle_cache cache(2);
+    const auto levels = merkle_cache::to_levels(block_100000);
+    const auto sequence = cache.sequence();
+    BOOST_REQUIRE(cache.put(1, levels, sequence));
+    BOOST_REQUIRE(cache.put(2, levels, sequence));
+
+    hash_list branch;
+    BOOST_REQUIRE(cache.get_branch(branch, 1, 0));
+    BOOST_REQUIRE(cache.put(3, levels, sequence));
+    BOOST_REQUIRE(cache.get_branch(branch, 1, 0));
+    BOOST_REQUIRE(!cache.get_branch(branch, 2, 0));
+    BOOST_REQUIRE(cache.get_branch(branch, 3, 0));
+}
+
+BOOST_AUTO_TEST_CASE(merkle_cache__reorganize__above_fork__dropped)
+{
+    merkle_cache cache(4);
+    const auto levels = merkle_cache::to_levels(block_100000);
+    const auto sequence = cache.sequence();
+    BOOST_REQUIRE(cache.put(10, levels, sequence));
+    BOOST_REQUIRE(cache.put(11, levels, sequence));
+    cache.reorganize(10, {});
+
+    hash_list branch;
+    BOOST_REQUIRE(cache.get_branch(branch, 10, 0));
+    BOOST_REQUIRE(!cache.get_branch(branch, 11, 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+using namespace bc::system::chain;
+
+BOOST_AUTO_TEST_SUITE(reorg_journal_tests)
+
+static const script script1(data_chunk{ 0x51 }, false);
+static const script script2(data_chunk{ 0x52 }, false);
+static constexpr size_t journal_depth = 100;
+
+// The point with the previous output cached as by validation.
+static output_point resolved(const output_point& point, const script& script)
+{
+    auto out = point;
+    out.metadata.cache = output(1, script);
+    return out;
+}
+
+static block_const_ptr new_block(const transaction::list& txs)
+{
+    return std::make_shared<const system::message::block>(chain::header{},
+        txs);
+}
+
+// A block with a transaction paying the key, distinguished by its spend.
+static block_const_ptr new_block(uint32_t index)
+{
+    return new_block(
+    {
+        transaction(1, 0, { input(resolved({ null_hash, index }, script2), {},
+            0) }, { output(1, script1) })
+    });
+}
+
+static block_const_ptr_list new_blocks(size_t count, uint32_t index)
+{
+    block_const_ptr_list blocks;
+
+    for (size_t block = 0; block < count; ++block)
+        blocks.push_back(new_block(index + static_cast<uint32_t>(block)));
+
+    return blocks;
+}
+
+// Extend the top by empty blocks.
+static void advance(reorg_journal& journal, size_t& top, size_t count)
+{
+    for (; count > 0; --count)
+        journal.reorganize(top++, new_blocks(1, 1000), {});
+}
+
+BOOST_AUTO_TEST_CASE(reorg_journal__removed__sync_above_fork__removals)
+{
+    reorg_journal journal(journal_depth);
+    const auto key = payment_key::to_key(script1);
+
+    // Replace heights 11..13 of a chain with top 13.
+    journal.reorganize(10, new_blocks(3, 0), new_blocks(3, 100));
+
+    size_t from;
+    reorg_journal::removal_list removals;
+    BOOST_REQUIRE(journal.removed(removals, from, key, 12));
+    BOOST_REQUIRE_EQUAL(from, 10u);
+    BOOST_REQUIRE_EQUAL(removals.size(), 2u);
+
+    removals.clear();
+    BOOST_REQUIRE(journal.removed(removals, from, key, 10));
+    BOOST_REQUIRE_EQUAL(from, 10u);
+    BOOST_REQUIRE(removals.empty());
+}
+
+BOOST_AUTO_TEST_CASE(reorg_journal__removed__accepted_sync_at_window_edge__removals)
+{
+    reorg_journal journal(journal_depth);
+    const auto key = payment_key::to_key(script1);
+    journal.reorganize(10, new_blocks(3, 0), new_blocks(3, 100));
+
+    // The fork point is out of the window, the outgoing height is not.
+    size_t top = 13;
+    advance(journal, top, journal_depth - 1);
+    BOOST_REQUIRE_GT(top, 10 + journal_depth);
+
+    size_t from;
+    reorg_journal::removal_list removals;
+    BOOST_REQUIRE(journal.removed(removals, from, key, 13));
+    BOOST_REQUIRE_EQUAL(from, 10u);
+    BOOST_REQUIRE_EQUAL(removals.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(reorg_journal__removed__sync_below_window__false)
+{
+    reorg_journal journal(journal_depth);
+    const auto key = payment_key::to_key(script1);
+    journal.reorganize(10, new_blocks(3, 0), new_blocks(3, 100));
+
+    size_t top = 13;
+    advance(journal, top, journal_depth + 1);
+
+    size_t from;
+    reorg_journal::removal_list removals;
+    BOOST_REQUIRE(!journal.removed(removals, from, key, 13));
+    BOOST_REQUIRE(journal.removed(removals, from, key, top - 1));
+    BOOST_REQUIRE(removals.empty());
+}
+
+BOOST_AUTO_TEST_CASE(reorg_journal__removed__spend_of_outgoing_output__removal)
+{
+    reorg_journal journal(journal_depth);
+    const auto key = payment_key::to_key(script1);
+    const transaction funding(1, 0,
+        { input(resolved({ null_hash, 0 }, script2), {}, 0) },
+        { output(1, script1) });
+
+    // The spend carries no previous output, it is keyed by the funding.
+    const transaction spend(1, 0, { input({ funding.hash(), 0 }, {}, 0) },
+        { output(1, script2) });
+
+    journal.reorganize(10, new_blocks(2, 0),
+        { new_block({ funding }), new_block({ spend }) });
+
+    size_t from;
+    reorg_journal::removal_list removals;
+    BOOST_REQUIRE(journal.removed(removals, from, key, 12));
+    BOOST_REQUIRE_EQUAL(from, 10u);
+    BOOST_REQUIRE_EQUAL(removals.size(), 2u);
+    BOOST_REQUIRE(removals.front().tx_hash == spend.hash() ||
+        removals.back().tx_hash == spend.hash());
+}
+
+BOOST_AUTO_TEST_CASE(reorg_journal__removed__unresolved_spend__false)
+{
+    reorg_journal journal(journal_depth);
+    const auto key = payment_key::to_key(script1);
+    const transaction spend(1, 0, { input({ null_hash, 0 }, {}, 0) },
+        { output(1, script2) });
+
+    journal.reorganize(10, new_blocks(1, 0), { new_block({ spend }) });
+
+    size_t from;
+    reorg_journal::removal_list removals;
+    BOOST_REQUIRE(!journal.removed(removals, from, key, 11));
+    BOOST_REQUIRE(journal.removed(removals, from, key, 10));
+    BOOST_REQUIRE(removals.empty());
+}
+
+BOOST_AUTO_TEST_CASE(reorg_journal__removed__disabled__false)
+{
+    reorg_journal journal(0);
+    const auto key = payment_key::to_key(script1);
+
+    size_t from;
+    reorg_journal::removal_list removals;
+    BOOST_REQUIRE(!journal.removed(removals, from, key, 0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
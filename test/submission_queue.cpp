@@ -0,0 +1,228 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <bitcoin/server.hpp>
+
+using namespace bc;
+using namespace bc::server;
+using namespace bc::system;
+
+BOOST_AUTO_TEST_SUITE(submission_queue_tests)
+
+static transaction_const_ptr new_transaction()
+{
+    return std::make_shared<const system::message::transaction>();
+}
+
+// Completes each organization asynchronously on its own thread.
+class async_organizer
+{
+public:
+    async_organizer()
+      : stopped_(false), thread_([this]() { run(); })
+    {
+    }
+
+    ~async_organizer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+
+        condition_.notify_one();
+        thread_.join();
+    }
+
+    void organize(transaction_const_ptr,
+        submission_queue::result_handler handler)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            handlers_.push_back(handler);
+        }
+
+        condition_.notify_one();
+    }
+
+private:
+    void run()
+    {
+        while (true)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]()
+            {
+                return stopped_ || !handlers_.empty();
+            });
+
+            if (handlers_.empty())
+                return;
+
+            const auto handler = handlers_.front();
+            handlers_.pop_front();
+            lock.unlock();
+            handler(error::success);
+        }
+    }
+
+    bool stopped_;
+    std::deque<submission_queue::result_handler> handlers_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::thread thread_;
+};
+
+BOOST_AUTO_TEST_CASE(submission_queue__submit__inline_completion__completes_all_in_order)
+{
+    static const size_t count = 100000;
+    size_t organized = 0;
+    std::vector<size_t> completions;
+    completions.reserve(count);
+
+    // Rejections complete within the organize call, which must not recurse.
+    submission_queue queue([&](transaction_const_ptr,
+        submission_queue::result_handler handler)
+    {
+        ++organized;
+        handler(error::operation_failed);
+    });
+
+    for (size_t index = 0; index < count; ++index)
+        queue.submit(new_transaction(), [&, index](const code& ec)
+        {
+            BOOST_REQUIRE_EQUAL(ec, error::operation_failed);
+            completions.push_back(index);
+        });
+
+    BOOST_REQUIRE_EQUAL(organized, count);
+    BOOST_REQUIRE_EQUAL(completions.size(), count);
+    BOOST_REQUIRE_EQUAL(queue.submitted(), count);
+
+    for (size_t index = 0; index < count; ++index)
+        BOOST_REQUIRE_EQUAL(completions[index], index);
+}
+
+BOOST_AUTO_TEST_CASE(submission_queue__submit__deferred_completion__batches_pending)
+{
+    std::deque<submission_queue::result_handler> outstanding;
+    size_t organized = 0;
+    size_t completed = 0;
+
+    submission_queue queue([&](transaction_const_ptr,
+        submission_queue::result_handler handler)
+    {
+        ++organized;
+        outstanding.push_back(handler);
+    });
+
+    const auto handler = [&](const code& ec)
+    {
+        BOOST_REQUIRE_EQUAL(ec, error::success);
+        ++completed;
+    };
+
+    // The first forms a batch of one, the next three arrive while it is
+    // organized and form the second batch.
+    queue.submit(new_transaction(), handler);
+    queue.submit(new_transaction(), handler);
+    queue.submit(new_transaction(), handler);
+    queue.submit(new_transaction(), handler);
+    BOOST_REQUIRE_EQUAL(organized, 1u);
+
+    // Each completion resumes the drain, which organizes the next.
+    while (!outstanding.empty())
+    {
+        const auto next = outstanding.front();
+        outstanding.pop_front();
+        next(error::success);
+    }
+
+    BOOST_REQUIRE_EQUAL(organized, 4u);
+    BOOST_REQUIRE_EQUAL(completed, 4u);
+    BOOST_REQUIRE_EQUAL(queue.batches(), 2u);
+}
+
+// Benchmark: a burst of submissions from concurrent submitters (as from
+// query workers) against an asynchronous organizer.
+BOOST_AUTO_TEST_CASE(submission_queue__submit__burst__benchmark)
+{
+    static const size_t submitters = 4;
+    static const size_t per_submitter = 5000;
+    static const size_t total = submitters * per_submitter;
+
+    std::atomic<size_t> completed(0);
+    std::mutex mutex;
+    std::condition_variable done;
+    async_organizer organizer;
+
+    submission_queue queue([&](transaction_const_ptr tx,
+        submission_queue::result_handler handler)
+    {
+        organizer.organize(tx, handler);
+    });
+
+    const auto handler = [&](const code&)
+    {
+        if (++completed == total)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_one();
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+
+    for (size_t thread = 0; thread < submitters; ++thread)
+        threads.emplace_back([&]()
+        {
+            for (size_t index = 0; index < per_submitter; ++index)
+                queue.submit(new_transaction(), handler);
+        });
+
+    for (auto& thread: threads)
+        thread.join();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return completed == total; });
+    }
+
+    const auto elapsed = std::chrono::duration_cast<
+        std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    BOOST_REQUIRE_EQUAL(queue.submitted(), total);
+    BOOST_REQUIRE_LE(queue.batches(), total);
+    BOOST_TEST_MESSAGE("submission_queue: " << total << " submissions in "
+        << queue.batches() << " batches, " << elapsed.count() << "us ("
+        << (total * 1000000u / (elapsed.count() + 1)) << "/s).");
+}
+
+BOOST_AUTO_TEST_SUITE_END()